@@ -0,0 +1,44 @@
+#include "CompilerOptions.hpp"
+#include "JackCompiler.hpp"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+/*
+Measures a full compilation of a Jack file or directory, from reading the source to writing the output, and
+reports the best time of the given number of runs and the peak resident set size of the process. Generate a large
+input with GenerateBigClass.
+
+Usage: CompileBench <file.jack OR dirname> [runs] [-O]
+*/
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: CompileBench <file.jack OR dirname> [runs] [-O]\n";
+        return 1;
+    }
+    int runs { argc > 2 ? std::atoi(argv[2]) : 5 };
+
+    Compiler::CompilerOptions options;
+    options.optimize = argc > 3 && std::strcmp(argv[3], "-O") == 0;
+
+    double best { 1e9 };
+    for (int run = 0; run < runs; ++run) {
+        auto start { std::chrono::steady_clock::now() };
+
+        Compiler::JackCompiler compiler;
+        if (compiler.compile(argv[1], options) != 0) { return 2; }
+
+        std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+        best = std::min(best, elapsed.count());
+    }
+
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "best of " << runs << ": " << best << " s, " << usage.ru_maxrss / 1024 << " MB max RSS\n";
+    return 0;
+}
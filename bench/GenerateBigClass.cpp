@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <string>
+
+/*
+Writes a large Jack class for the tokenizer and compiler benchmarks. The fields of test/Pong/Ball.jack are declared
+once, and its subroutines are repeated the given number of times, each copy renamed with a _<copy> suffix. The
+default of 2000 copies gives the 9.7 MB, 1.67M token Big.jack used for the figures quoted in the commit history.
+
+Usage: GenerateBigClass [copies] [Ball.jack] [output file]
+*/
+int main(int argc, char* argv[]) {
+    long copies { argc > 1 ? std::atol(argv[1]) : 2000 };
+    std::string infile { argc > 2 ? argv[2] : "test/Pong/Ball.jack" };
+    std::string outfile { argc > 3 ? argv[3] : "Big.jack" };
+
+    std::ifstream in(infile);
+    if (!in) {
+        std::cerr << "Cannot open " << infile << '\n';
+        return 1;
+    }
+    std::string source { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    source.erase(std::remove(source.begin(), source.end(), '\r'), source.end());   // output uses \n line endings
+
+    // the class body runs from the brace after "class Ball" to the last brace; subroutines start at the doc
+    // comment of the first constructor
+    std::size_t open { source.find('{', source.find("class Ball")) };
+    std::size_t close { source.rfind('}') };
+    std::string body { source.substr(open + 1, close - open - 1) };
+
+    std::smatch firstSubroutine;
+    if (!std::regex_search(body, firstSubroutine, std::regex(R"(\n\s*/\*\*[^\n]*\n\s*constructor)"))) {
+        std::cerr << "No constructor found in " << infile << '\n';
+        return 1;
+    }
+    std::string fields { body.substr(0, firstSubroutine.position()) };
+    std::string subroutines { body.substr(firstSubroutine.position()) };
+
+    std::ofstream out(outfile, std::ios::binary);
+    out << "// generated\nclass Big {\n" << fields;
+
+    std::regex declaration(R"(((?:constructor|function|method)\s+\w+\s+)(\w+)\()");
+    for (long copy = 0; copy < copies; ++copy) {
+        out << std::regex_replace(subroutines, declaration, "$1$2_" + std::to_string(copy) + "(");
+    }
+    out << "}\n";
+
+    std::cout << "Wrote " << copies << " copies to " << outfile << '\n';
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "InternPool.hpp"
+#include "JackTokenizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+
+namespace fs = std::filesystem;
+
+// every allocation in the process is counted, so each run can report how many it made
+static std::size_t allocations { 0 };
+static std::size_t allocatedBytes { 0 };
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    allocatedBytes += size;
+    if (void* memory = std::malloc(size)) { return memory; }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+/*
+Measures JackTokenizer throughput on a single Jack file, reporting the token count and the best time and MB/s of
+the given number of runs, along with the size of a Token and the heap allocations and bytes of one run. Generate
+a large input with GenerateBigClass.
+
+Usage: TokenizerBench <file.jack> [runs]
+*/
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: TokenizerBench <file.jack> [runs]\n";
+        return 1;
+    }
+    fs::path infile { argv[1] };
+    int runs { argc > 2 ? std::atoi(argv[2]) : 5 };
+
+    double best { 1e9 };
+    long tokens { 0 };
+    std::size_t runAllocations { 0 };
+    std::size_t runBytes { 0 };
+    for (int run = 0; run < runs; ++run) {
+        std::size_t allocationsBefore { allocations };
+        std::size_t bytesBefore { allocatedBytes };
+
+        Compiler::InternPool pool;
+        auto start { std::chrono::steady_clock::now() };
+
+        Compiler::JackTokenizer tokenizer(infile, pool);
+        tokens = 0;
+        while (tokenizer.hasMoreTokens()) {
+            tokenizer.advance();
+            ++tokens;
+        }
+
+        std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+        best = std::min(best, elapsed.count());
+        runAllocations = allocations - allocationsBefore;
+        runBytes = allocatedBytes - bytesBefore;
+    }
+
+    double megabytes { static_cast<double>(fs::file_size(infile)) / 1e6 };
+    std::cout << tokens << " tokens, best of " << runs << ": " << best << " s, " << megabytes / best << " MB/s\n"
+              << sizeof(Compiler::Token) << " bytes/token, " << runAllocations << " allocations, " << runBytes
+              << " bytes allocated per run\n";
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMTextWriter.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+/*
+Measures VMTextWriter throughput in emitted lines per second, using a mix of commands similar to compiled Jack code:
+string literals (push constant + call String.appendChar per character), variable access, arithmetic and branches.
+
+Usage: VMWriterBench [millions of lines] [output file]
+*/
+int main(int argc, char* argv[]) {
+    long millions { argc > 1 ? std::atol(argv[1]) : 10 };
+    fs::path outfile { argc > 2 ? argv[2] : "VMWriterBench.vm" };
+    long target { millions * 1000000 };
+
+    Compiler::InternPool pool;
+    Compiler::Name function { pool.intern("Bench.run") };
+    Compiler::Name callee { pool.intern("Output.printString") };
+
+    long lines { 0 };
+    auto start { std::chrono::steady_clock::now() };
+    {
+        Compiler::VMTextWriter writer(outfile, pool);
+        for (int label = 0; lines < target; label += 2) {
+            writer.writeFunction(function, 4);
+            writer.writeLabel(label);
+            writer.writePush(Compiler::Segment::LOCAL, 0);
+            writer.writePush(Compiler::Segment::ARG, 1);
+            writer.writeArithmetic(Compiler::Command::LT);
+            writer.writeArithmetic(Compiler::Command::NOT);
+            writer.writeIf(label + 1);
+            writer.writeConstant(12);
+            writer.writeCall(Compiler::BuiltinName::STRING_NEW, 1);
+            for (int chr = 'a'; chr < 'a' + 12; ++chr) {
+                writer.writeConstant(chr);
+                writer.writeCall(Compiler::BuiltinName::STRING_APPENDCHAR, 2);
+            }
+            writer.writeCall(callee, 1);
+            writer.writePop(Compiler::Segment::TEMP, 0);
+            writer.writePush(Compiler::Segment::LOCAL, 0);
+            writer.writeConstant(1);
+            writer.writeArithmetic(Compiler::Command::ADD);
+            writer.writePop(Compiler::Segment::LOCAL, 0);
+            writer.writeGoto(label);
+            writer.writeLabel(label + 1);
+            writer.writeReturn();
+            lines += 44;
+        }
+    }
+    std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+
+    std::error_code error;
+    std::uintmax_t bytes { fs::file_size(outfile, error) };
+    fs::remove(outfile, error);
+
+    std::cout << lines << " lines, " << bytes << " bytes in " << elapsed.count() << " s: "
+              << static_cast<long>(lines / elapsed.count()) << " lines/s\n";
+    return 0;
+}
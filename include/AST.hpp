@@ -0,0 +1,141 @@
+#ifndef AST_H
+#define AST_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+namespace Compiler {
+
+/**
+ * Index of a node in its AST arena.
+ */
+using NodeId = std::uint32_t;
+
+/**
+ * Nodes link to each other with 24-bit indices, so an arena holds at most NO_NODE nodes.
+ */
+constexpr NodeId NO_NODE { (1u << 24) - 1 };
+
+/**
+ * Enums for each kind of AST node, with the meaning of the op and value fields and the children of each.
+ */
+enum class NodeKind : std::uint8_t {
+    BLOCK,          // children: statements
+    LET,            // children: target (VAR or ARRAY_ELEM), value expression
+    IF,             // children: condition, then BLOCK, optional else BLOCK
+    WHILE,          // children: condition, body BLOCK
+    DO,             // children: CALL
+    RETURN,         // children: optional value expression
+
+    INT_CONST,      // value: integer constant
+    STRING_CONST,   // value: index into the AST string table
+    KEYWORD_CONST,  // op: Keyword (true, false, null, this)
+    VAR,            // op: Segment, value: segment index
+    ARRAY_ELEM,     // children: base VAR, index expression
+    CALL,           // value: qualified function Name; children: arguments, with the receiver first for methods
+    UNARY,          // op: Symbol (minus, squiggle); children: operand
+    BINARY          // op: Symbol; children: left operand, right operand
+};
+
+/**
+ * A single AST node. Children are linked through their first child and next sibling indices, which share a word
+ * with the op and kind so that a node takes 12 bytes.
+ */
+struct Node {
+    std::uint32_t value;
+    NodeId firstChild : 24;
+    std::uint8_t op;
+    NodeId nextSibling : 24;
+    NodeKind kind;
+
+    Keyword keyword() const { return static_cast<Keyword>(op); }
+    Symbol symbol() const { return static_cast<Symbol>(op); }
+    Segment segment() const { return static_cast<Segment>(op); }
+};
+
+static_assert(sizeof(Node) == 12);
+
+/**
+ * Models a subroutine declaration with its qualified VM function name, kind, local variable count, and body BLOCK.
+ */
+struct SubroutineDec {
+    Name name;
+    Keyword kind;
+    int nLocals;
+    NodeId body;
+};
+
+/**
+ * Arena holding the tree of a single class. All nodes live in one contiguous vector and refer to each other by index,
+ * so the whole tree is released in one step by clear() or destruction.
+ */
+class AST {
+public:
+    Name className;
+    int nFields;
+    int nStatics;
+    std::vector<SubroutineDec> subroutines;
+
+    /**
+     * Reserves room for the provided number of nodes so the arena grows in one allocation.
+     */
+    void reserve(std::size_t nodeCount);
+
+    /**
+     * Appends a new childless node to the arena and returns its index. Throws a JackCompilerError if the arena is full.
+     */
+    NodeId addNode(NodeKind kind, std::uint8_t op = 0, std::uint32_t value = 0);
+
+    /**
+     * Links the provided nodes, in order, as the children of the parent node.
+     */
+    void adopt(NodeId parent, const NodeId* first, const NodeId* last);
+    void adopt(NodeId parent, std::initializer_list<NodeId> children);
+
+    /**
+     * Stores a string constant and returns its index in the string table.
+     */
+    std::uint32_t addString(std::string_view str);
+
+    /**
+     * Returns the string constant at the provided index.
+     */
+    std::string_view string(std::uint32_t index) const;
+
+    /**
+     * Returns the index of the nth child of the provided node, or NO_NODE if it has fewer children.
+     */
+    NodeId child(NodeId node, int n = 0) const;
+
+    /**
+     * Returns the number of children of the provided node.
+     */
+    int childCount(NodeId node) const;
+
+    /**
+     * Returns the number of nodes in the arena.
+     */
+    std::size_t size() const;
+
+    /**
+     * Releases every node, string, and subroutine in the arena.
+     */
+    void clear();
+
+    Node& operator[](NodeId id) { return nodes[id]; }
+    const Node& operator[](NodeId id) const { return nodes[id]; }
+
+private:
+    std::vector<Node> nodes;
+    std::vector<std::string_view> strings;
+};
+
+}
+
+#endif
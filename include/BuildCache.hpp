@@ -0,0 +1,68 @@
+#ifndef BUILDCACHE_H
+#define BUILDCACHE_H
+
+#include "CompilerOptions.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+class BuildCache {
+public:
+    /**
+     * Creates a new BuildCache module backed by the cache file in the provided directory, loading any entries
+     * saved by a previous run. A missing, unreadable or outdated cache file starts an empty cache.
+     */
+    BuildCache(const fs::path& dirname, const CompilerOptions& options);
+
+    /**
+     * Returns the cache key of the provided source file: a hash of its contents, the compiler version, and every
+     * flag that affects the generated code. Returns 0 if the file cannot be read, which never matches an entry.
+     */
+    std::uint64_t key(const fs::path& infile) const;
+
+    /**
+     * Returns whether or not the output of the provided source file is up to date: its last successful compilation
+     * had the same key, and the VM file it wrote is still present with the same size.
+     */
+    bool isFresh(const fs::path& infile, const fs::path& outfile, std::uint64_t key) const;
+
+    /**
+     * Records a successful compilation of the provided source file.
+     */
+    void update(const fs::path& infile, const fs::path& outfile, std::uint64_t key);
+
+    /**
+     * Writes all entries whose source file still exists back to the cache file.
+     */
+    void save() const;
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        std::uintmax_t outputSize;
+    };
+
+    static const fs::path CACHE_FILE;
+    static constexpr std::string_view CACHE_HEADER { "jackcache 1" };
+
+    // bump whenever the output of a VM writer changes; code generation carries its own revisions, see
+    // CODEGEN_REVISIONS in BuildCache.cpp
+    static constexpr std::string_view COMPILER_VERSION { "1.2" };
+
+    fs::path directory;
+    std::uint64_t configHash;
+    std::map<std::string, Entry> entries;   // keyed on source filename; ordered so the saved file is stable
+
+    void load();
+};
+
+}
+
+#endif
@@ -1,14 +1,21 @@
 #ifndef COMPILATIONENGINE_H
 #define COMPILATIONENGINE_H
 
+#include "AST.hpp"
+#include "CompilerOptions.hpp"
 #include "CompilerResources.hpp"
-#include "JackTokenizer.hpp"
-#include "SymbolTable.hpp"
+#include "ControlFlowOptimizer.hpp"
+#include "InternPool.hpp"
+#include "JackParser.hpp"
+#include "PeepholeOptimizer.hpp"
 #include "VMWriter.hpp"
 
+#include <array>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -17,85 +24,94 @@ namespace Compiler {
 
 namespace fs = std::filesystem;
 
+/**
+ * Counts of the changes made by the optimizations while compiling a single class.
+ */
+struct OptimizationStats {
+    int mathCallsRemoved { 0 };
+    int invariantsHoisted { 0 };
+    int subexpressionsReused { 0 };
+    int stringsPooled { 0 };
+    std::array<int, PeepholeOptimizer::RULE_COUNT> peepholeHits {};
+    FlowStats flow;
+    int localsRemoved { 0 };
+};
+
 class CompilationEngine {
 public:
+    static constexpr int REVISION { 5 };
+
     /**
-     * Creates a new CompilationEngine module, compiles the provided infile into VM commands and writes them to the provided outfile.
+     * Creates a new CompilationEngine module, compiles the provided infile into VM commands and sends them to the provided writer.
+     * The class is first parsed into an AST, then VM code is generated by a separate walk over the tree.
+     * Identifiers are interned into the provided pool, which may be shared by every file in a compilation run.
+     * With options.optimize, the tree is simplified by the optimization passes before code generation.
      */
-    CompilationEngine(const fs::path& infile, const fs::path& outfile, std::ofstream* const debugFile);
+    CompilationEngine(const fs::path& infile, std::unique_ptr<VMWriter> vmWriter, InternPool& namePool, const CompilerOptions& options, std::ostream* const debugFile);
 
-private:
-    static const std::string MATH_MULTIPLY;
-    static const std::string MATH_DIVIDE;
-    static const std::string MEMORY_ALLOC;
-    static const std::string STRING_NEW;
-    static const std::string STRING_APPENDCHAR;
+    /**
+     * Returns the counts of the optimizations applied to the class.
+     */
+    const OptimizationStats& getStats() const;
 
+private:
     static const std::unordered_map<Symbol, Command> commandLookup;
-    static const std::unordered_map<Symbol, std::string> mathLookup;
+    static const std::unordered_map<Symbol, Name> mathLookup;
 
-    JackTokenizer tokenizer;
-    VMWriter writer;
-    int labelCount;
-    std::string currClassName;
-
-    SymbolTable classSymbols;
-    SymbolTable methodSymbols;
-
-    static void handleInvalidToken(const Token& token, const TokenReq& req, const std::string* customReqName = nullptr);
+    static constexpr int MAX_MULTIPLY_CHAIN { 40 };     // longest add chain, in VM commands, that replaces Math.multiply
+    static constexpr int MULTIPLY_OPERAND_TEMP { 1 };
+    static constexpr int MULTIPLY_PRODUCT_TEMP { 2 };
+    static constexpr std::string_view STRING_INIT_FUNCTION { "$initStrings" };
 
-    std::string getLabel();
-    std::pair<std::string, std::string> getLabelPair();
-
-    bool compareToken(const Token& token, const TokenReq& req) const;
-    TokenVal process(const TokenReq& req);
-    const TokenReq* compareTokens(const Token& token, const std::vector<TokenReq>& reqsList) const;
-    bool nextTokenIs(const TokenReq& req) const;
-    const TokenReq* nextTokenIsOneOf(const std::vector<TokenReq>& reqsList) const;
-
-    Keyword processKeyword();
-    Symbol processSymbol();
-    int processIntConst();
-    std::string processStringConst();
-    std::string processIdentifier();
+    JackParser parser;
+    AST ast;
+    std::unique_ptr<VMWriter> writer;
+    InternPool& pool;
+    int labelCount;
+    bool optimize;
+    bool poolStrings;
+    OptimizationStats stats;
 
-    TokenVal verifySet(const std::vector<TokenReq>& reqsList, const std::string& setName);
-    TokenVal verifyVarType();
-    TokenVal verifyReturnType();
+    // string pooling: static index of each distinct literal, in order of first use
+    std::unordered_map<std::string_view, int> stringSlots;
+    std::vector<std::string_view> pooledStrings;
+    std::vector<bool> subroutineUsesStrings;
+    Name stringInitName;
 
-    bool isClassVarDec() const;
-    bool isSubroutineDec() const;
-    bool isVarDec() const;
-    bool isStatement() const;
+    // -O: expressions whose value is reused later in their statement, with the local holding the copy
+    std::unordered_map<NodeId, int> cachedValues;
 
-    bool termIsSubroutineCall() const;
-    bool termIsArrayExp() const;
+    int getLabel();
+    std::pair<int, int> getLabelPair();
 
-    const SymbolTable* getVarScope(const std::string& name) const;
+    void collectStrings(NodeId node, bool& usesStrings);
+    void compileStringPoolGuard();
+    void compileStringPoolInit();
 
     void compileClass();
-    void compileClassVarDec();
-    void compileSubroutine();
-    void compileParameterList();
-    void compileSubroutineBody(const std::string& name, const Keyword& type);
-    void compileVarDec();
-    void compileFunctionHeader(const std::string& name, const Keyword& type);
-    std::string compileVarName(const std::string& type, const Segment& segment, SymbolTable& symbolTable);
-    const SymbolTable::Entry* compileVarName();
-    std::string compileName();
-    void compileSubroutineCall();
-    void compileStatements();
-    void compileLet();
-    void compileIf();
-    void compileWhile();
-    void compileDo();
-    void compileReturn();
-    void compileExpression();
-    void compileTerm();
-    int compileExpressionList();
-    void compileStrConstTerm();
-    void compileKeywordConstTerm();
-    void compileIdentifierTerm();
+    void compileSubroutine(const SubroutineDec& subroutine, bool initStrings);
+    void compileFunctionHeader(const SubroutineDec& subroutine);
+    void compileSubroutineCall(NodeId call);
+    void compileStatements(NodeId block);
+    void compileLet(NodeId let);
+    void compileIf(NodeId ifNode);
+    void compileWhile(NodeId whileNode);
+    void compileFalseBranch(NodeId condition, int label);
+    bool isBoolean(NodeId expression) const;
+    void compileDo(NodeId doNode);
+    void compileReturn(NodeId returnNode);
+    void compileExpression(NodeId expression);
+    void compileValue(NodeId expression);
+    bool compileConstantMultiply(NodeId expression);
+    void compileTerm(NodeId term);
+    void compileIntConstTerm(NodeId term);
+    void compileStrConstTerm(NodeId term);
+    void compileNewString(std::string_view str);
+    void compileKeywordConstTerm(NodeId term);
+    void compileVarTerm(NodeId term);
+    void compileArrayTerm(NodeId term);
+    int compileArrayAddress(NodeId element);
+    bool preservesThatPointer(NodeId expression) const;
 };
 
 }
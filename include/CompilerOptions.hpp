@@ -0,0 +1,49 @@
+#ifndef COMPILEROPTIONS_H
+#define COMPILEROPTIONS_H
+
+namespace Compiler {
+
+/**
+ * File formats the compiler can write its output in.
+ */
+enum class OutputFormat {
+    VM,     // textual VM commands (.vm)
+    VMB,    // binary VM bytecode (.vmb), see VMBinaryWriter
+    ASM,    // Hack assembly for the whole program (.asm), see HackWriter
+    HACK    // Hack machine code for the whole program (.hack), see HackAssembler
+};
+
+/**
+ * Returns whether or not the provided format is written as a single file for the whole program instead of one
+ * file per class.
+ */
+constexpr bool isWholeProgram(OutputFormat format) {
+    return format == OutputFormat::ASM || format == OutputFormat::HACK;
+}
+
+/**
+ * Settings selected by the command-line flags of a single compiler run.
+ */
+struct CompilerOptions {
+    bool debugMode { false };   // -d: write symbol tables to the debug file
+    unsigned jobs { 1 };        // -j N: number of files compiled at the same time
+    bool useCache { false };    // --cache: skip files whose source and flags match the previous build
+    bool optimize { false };    // -O: optimize the generated code
+    bool reportStats { false }; // --stats: print the optimizations applied to each file
+    bool poolStrings { false }; // --pool-strings: build each string literal once per class and share it
+    bool prune { false };       // --prune: drop functions unreachable from Sys.init and Main.main
+    unsigned inlineLimit { 0 }; // --inline[=N]: inline leaf functions of up to N commands at their call sites
+    OutputFormat format { OutputFormat::VM };   // --emit=vm|vmb|asm|hack: output file format
+};
+
+/**
+ * Returns whether or not the provided options analyze the whole program, so that every class must be compiled
+ * before any output is written.
+ */
+constexpr bool isWholeProgramAnalysis(const CompilerOptions& options) {
+    return options.prune || options.inlineLimit > 0;
+}
+
+}
+
+#endif
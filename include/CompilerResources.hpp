@@ -1,11 +1,18 @@
 #ifndef COMPILERRESOURCES_H
 #define COMPILERRESOURCES_H
 
+#include "InternPool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <initializer_list>
+#include <optional>
+#include <ostream>
 #include <string>
-#include <unordered_map>
-#include <variant>
-#include <vector>
+#include <string_view>
+#include <type_traits>
 
 namespace Compiler {
 
@@ -45,10 +52,26 @@ public:
     SymbolError(const std::string& symbol);
 };
 
+/**
+ * Indicates the tokenizer has reached input that cannot form a complete token.
+ */
+class LexicalError : public JackCompilerError {
+public:
+    LexicalError(const std::string& reason);
+};
+
+/**
+ * Indicates an input file could not be opened.
+ */
+class FileError : public JackCompilerError {
+public:
+    FileError(const std::string& filename);
+};
+
 /**
  * Enums for each Jack grammar token type.
  */
-enum class TokenType {
+enum class TokenType : std::uint8_t {
     KEYWORD,
     SYMBOL,
     INT_CONST,
@@ -143,42 +166,98 @@ enum class Command {
 };
 
 /**
- * Token value can be any integer, string constant, or keyword/symbol enum.
+ * Required token can be either a token type (any value that matches the type permitted) or a keyword/symbol value.
+ */
+struct TokenReq {
+    TokenType type;
+    bool anyValue;
+    std::uint32_t value;
+
+    constexpr TokenReq(TokenType t) : type(t), anyValue(true), value(0) {}
+    constexpr TokenReq(Keyword k) : type(TokenType::KEYWORD), anyValue(false), value(static_cast<std::uint32_t>(k)) {}
+    constexpr TokenReq(Symbol s) : type(TokenType::SYMBOL), anyValue(false), value(static_cast<std::uint32_t>(s)) {}
+};
+
+/**
+ * String tables indexed by enum value. Each table must list its strings in the declaration order of its enum.
  */
-using TokenVal = std::variant<Keyword, Symbol, int, std::string>;
+inline constexpr std::string_view TYPE_STRINGS[] { "keyword", "symbol", "int const", "string const", "identifier" };
+
+inline constexpr std::string_view KEYWORD_STRINGS[] {
+    "class", "constructor", "function", "method", "field", "static", "var",
+    "int", "char", "boolean", "void",
+    "true", "false", "null", "this",
+    "let", "do", "if", "else", "while", "return"
+};
+
+inline constexpr char SYMBOL_CHARS[] { '{', '}', '(', ')', '[', ']', '.', ',', ';', '+', '-', '*', '/', '&', '|', '<', '>', '=', '~' };
+
+inline constexpr std::string_view SEGMENT_STRINGS[] { "field", "this", "static", "argument", "local", "constant", "that", "pointer", "temp" };
+
+inline constexpr std::string_view COMMAND_STRINGS[] { "add", "sub", "neg", "eq", "gt", "lt", "and", "or", "not" };
+
+constexpr std::string_view toString(TokenType type) { return TYPE_STRINGS[static_cast<std::size_t>(type)]; }
+constexpr std::string_view toString(Keyword keyword) { return KEYWORD_STRINGS[static_cast<std::size_t>(keyword)]; }
+constexpr std::string_view toString(Symbol symbol) { return std::string_view(&SYMBOL_CHARS[static_cast<std::size_t>(symbol)], 1); }
+constexpr std::string_view toString(Segment segment) { return SEGMENT_STRINGS[static_cast<std::size_t>(segment)]; }
+constexpr std::string_view toString(Command command) { return COMMAND_STRINGS[static_cast<std::size_t>(command)]; }
 
 /**
- * Required token can be either a token type (any value that matches the type permitted) or token value.
+ * Perfect hash over the keyword strings, using only the length and the first and last characters.
+ * The multipliers were chosen so that no two keywords share a slot; buildKeywordSlots rejects any collision at compile time.
  */
-using TokenReq = std::variant<TokenType, TokenVal>;
+constexpr std::size_t keywordHash(std::string_view word) {
+    return (word.size() + 8 * static_cast<unsigned char>(word.front()) + 27 * static_cast<unsigned char>(word.back())) & 31;
+}
+
+constexpr std::array<std::int8_t, 32> buildKeywordSlots() {
+    std::array<std::int8_t, 32> slots {};
+    for (std::int8_t& slot : slots) { slot = -1; }
+
+    for (std::size_t i = 0; i < std::size(KEYWORD_STRINGS); ++i) {
+        std::int8_t& slot { slots[keywordHash(KEYWORD_STRINGS[i])] };
+        if (slot != -1) { throw "keyword hash collision"; }
+        slot = static_cast<std::int8_t>(i);
+    }
+    return slots;
+}
+
+constexpr std::array<std::int8_t, 128> buildSymbolSlots() {
+    std::array<std::int8_t, 128> slots {};
+    for (std::int8_t& slot : slots) { slot = -1; }
+
+    for (std::size_t i = 0; i < std::size(SYMBOL_CHARS); ++i) {
+        slots[static_cast<std::size_t>(SYMBOL_CHARS[i])] = static_cast<std::int8_t>(i);
+    }
+    return slots;
+}
+
+inline constexpr std::array<std::int8_t, 32> KEYWORD_SLOTS { buildKeywordSlots() };
+inline constexpr std::array<std::int8_t, 128> SYMBOL_SLOTS { buildSymbolSlots() };
 
 /**
- * Predefined token sets to match/validate certain conditions during the compilation process.
+ * Returns the keyword enum spelled by the provided word, if any.
  */
-namespace TokenSet {
-    extern std::vector<TokenReq> DATA_TYPES;
-    extern std::vector<TokenReq> RETURN_TYPES;
-    extern std::vector<TokenReq> CLASS_VAR_DEC;
-    extern std::vector<TokenReq> SUBROUTINE_DEC;
-    extern std::vector<TokenReq> STATEMENTS;
-    extern std::vector<TokenReq> UNARY_OPS;
-    extern std::vector<TokenReq> OPERATORS;
-    extern std::vector<TokenReq> KEYWORD_CONSTANTS;
-    extern std::vector<TokenReq> TERMS;
-    extern std::vector<TokenReq> SUBROUTINE_CALL;
-
-    void init();
+constexpr std::optional<Keyword> strToKeyword(std::string_view word) {
+    if (word.empty()) { return std::nullopt; }
+
+    std::int8_t slot { KEYWORD_SLOTS[keywordHash(word)] };
+    if (slot == -1 || KEYWORD_STRINGS[slot] != word) { return std::nullopt; }
+    return static_cast<Keyword>(slot);
 }
 
-extern const std::unordered_map<std::string, Keyword> strToKeyword;
-extern const std::unordered_map<std::string, Symbol> strToSymbol;
-extern const std::unordered_map<std::string, Segment> strToSegment;
+/**
+ * Returns the symbol enum of the provided character, if any.
+ */
+constexpr std::optional<Symbol> charToSymbol(char chr) {
+    unsigned char index { static_cast<unsigned char>(chr) };
+    if (index >= SYMBOL_SLOTS.size() || SYMBOL_SLOTS[index] == -1) { return std::nullopt; }
+    return static_cast<Symbol>(SYMBOL_SLOTS[index]);
+}
 
-extern const std::unordered_map<TokenType, std::string> typeToStr;
-extern const std::unordered_map<Keyword, std::string> keywordToStr;
-extern const std::unordered_map<Symbol, std::string> symbolToStr;
-extern const std::unordered_map<Segment, std::string> segmentToStr;
-extern const std::unordered_map<Command, std::string> commandToStr;
+static_assert(strToKeyword("constructor") == Keyword::CONSTRUCTOR && strToKeyword("return") == Keyword::RETURN);
+static_assert(!strToKeyword("Class") && !strToKeyword("retur"));
+static_assert(charToSymbol('~') == Symbol::SQUIGGLE && !charToSymbol('@'));
 
 /**
  * Writes a string representation of a memory segment enum to output.
@@ -195,6 +274,11 @@ std::ostream& operator<<(std::ostream& os, const Command& command);
  */
 std::string operator+(const Keyword& keyword);
 
+/**
+ * Converts and returns the string representation of a token type enum.
+ */
+std::string operator+(const TokenType& type);
+
 /**
  * Converts and returns the string representation of any requirement token.
  */
@@ -203,19 +287,140 @@ std::string reqToString(const TokenReq& req);
 /**
  * Converts and returns the segment enum equivalent of any memory-related keyword enum.
  */
-Segment keywordToSegment(const Keyword& keyword);
+constexpr Segment keywordToSegment(const Keyword& keyword) {
+    switch (keyword) {
+        case Keyword::FIELD:  return Segment::FIELD;
+        case Keyword::STATIC: return Segment::STATIC;
+        case Keyword::VAR:    return Segment::LOCAL;
+        default:              return Segment::THIS;
+    }
+}
 
 /**
- * Represents a token in the input file with a type and value.
+ * Represents a token in the input file with a type, a small value, and the location of its text in the source.
+ * The value holds the keyword/symbol enum, integer constant, or interned identifier handle; token text is
+ * recovered from the source with JackTokenizer::text. Trivially copyable so lookahead moves plain words.
  */
 struct Token {
+    std::uint32_t offset;
+    std::uint32_t value;
+    std::uint16_t length;
     TokenType type;
-    TokenVal val;
 
-    Token() {}
-    Token(TokenType t, TokenVal v) : type(t), val(v) {}
+    Token() = default;
+    constexpr Token(TokenType t, std::uint32_t v, std::uint32_t off, std::uint16_t len) :
+        offset(off), value(v), length(len), type(t) {}
+
+    Keyword keyword() const { return static_cast<Keyword>(value); }
+    Symbol symbol() const { return static_cast<Symbol>(value); }
+    int intVal() const { return static_cast<int>(value); }
+    Name name() const { return value; }
+};
+
+static_assert(std::is_trivially_copyable_v<Token> && sizeof(Token) == 12);
+
+/**
+ * Immutable set of token requirements stored as a bitmask: one bit per keyword, per symbol, and per token type
+ * (the wildcard requirements). Membership of a token is a single AND against the bits the token can satisfy.
+ */
+class TokenReqSet {
+public:
+    constexpr TokenReqSet(std::initializer_list<TokenReq> reqs) : bits(0) {
+        for (const TokenReq& req : reqs) { bits |= reqBit(req); }
+    }
+
+    constexpr TokenReqSet operator|(const TokenReqSet& other) const {
+        return TokenReqSet(bits | other.bits);
+    }
+
+    /**
+     * Returns whether or not the provided token satisfies any requirement in the set.
+     */
+    constexpr bool contains(const Token& token) const {
+        std::uint64_t tokenBits { bit(TYPE_BASE + static_cast<unsigned>(token.type)) };
+        if (token.type == TokenType::KEYWORD) {
+            tokenBits |= bit(KEYWORD_BASE + token.value);
+        } else if (token.type == TokenType::SYMBOL) {
+            tokenBits |= bit(SYMBOL_BASE + token.value);
+        }
+        return (bits & tokenBits) != 0;
+    }
+
+private:
+    static constexpr unsigned KEYWORD_BASE { 0 };
+    static constexpr unsigned SYMBOL_BASE { KEYWORD_BASE + static_cast<unsigned>(std::size(KEYWORD_STRINGS)) };
+    static constexpr unsigned TYPE_BASE { SYMBOL_BASE + static_cast<unsigned>(std::size(SYMBOL_CHARS)) };
+    static_assert(TYPE_BASE + std::size(TYPE_STRINGS) <= 64);
+
+    std::uint64_t bits;
+
+    constexpr explicit TokenReqSet(std::uint64_t b) : bits(b) {}
+
+    static constexpr std::uint64_t bit(unsigned index) { return std::uint64_t { 1 } << index; }
+
+    static constexpr std::uint64_t reqBit(const TokenReq& req) {
+        if (req.anyValue) {
+            return bit(TYPE_BASE + static_cast<unsigned>(req.type));
+        }
+        return bit((req.type == TokenType::KEYWORD ? KEYWORD_BASE : SYMBOL_BASE) + req.value);
+    }
 };
 
+/**
+ * Predefined token sets to match/validate certain conditions during the compilation process.
+ */
+namespace TokenSet {
+    inline constexpr TokenReqSet CLASS_VAR_DEC { Keyword::STATIC, Keyword::FIELD };
+    inline constexpr TokenReqSet SUBROUTINE_DEC { Keyword::CONSTRUCTOR, Keyword::FUNCTION, Keyword::METHOD };
+    inline constexpr TokenReqSet SUBROUTINE_CALL { Symbol::PAREN_L, Symbol::DOT };
+    inline constexpr TokenReqSet UNARY_OPS { Symbol::MINUS, Symbol::SQUIGGLE };
+
+    inline constexpr TokenReqSet DATA_TYPES {
+        Keyword::INT,
+        Keyword::CHAR,
+        Keyword::BOOLEAN,
+        TokenType::IDENTIFIER
+    };
+
+    inline constexpr TokenReqSet RETURN_TYPES { TokenReqSet { Keyword::VOID } | DATA_TYPES };
+
+    inline constexpr TokenReqSet STATEMENTS {
+        Keyword::LET,
+        Keyword::IF,
+        Keyword::WHILE,
+        Keyword::DO,
+        Keyword::RETURN
+    };
+
+    inline constexpr TokenReqSet OPERATORS {
+        Symbol::PLUS,
+        Symbol::MINUS,
+        Symbol::STAR,
+        Symbol::SLASH,
+        Symbol::AMPERSAND,
+        Symbol::VERTICAL_BAR,
+        Symbol::LESS_THAN,
+        Symbol::GREATER_THAN,
+        Symbol::EQUAL
+    };
+
+    inline constexpr TokenReqSet KEYWORD_CONSTANTS {
+        Keyword::TRUE,
+        Keyword::FALSE,
+        Keyword::NULL_KW,
+        Keyword::THIS
+    };
+
+    inline constexpr TokenReqSet TERMS {
+        TokenReqSet {
+            TokenType::INT_CONST,
+            TokenType::STRING_CONST,
+            TokenType::IDENTIFIER,
+            Symbol::PAREN_L
+        } | KEYWORD_CONSTANTS | UNARY_OPS
+    };
+}
+
 }
 
 #endif
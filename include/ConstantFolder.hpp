@@ -0,0 +1,49 @@
+#ifndef CONSTANTFOLDER_H
+#define CONSTANTFOLDER_H
+
+#include "AST.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace Compiler {
+
+/*
+Evaluates constant subexpressions of a class AST in place, with the 16-bit wraparound semantics of the Hack
+platform, and applies algebraic identities (x+0, x*1, x*0, --x, ...). An operand is only dropped when evaluating
+it has no side effects: it makes no calls, builds no strings, and divides by nothing.
+Folded constants may be negative or exceed 32767; INT_CONST values hold the 16-bit pattern.
+*/
+class ConstantFolder {
+public:
+    static constexpr int REVISION { 1 };
+
+    /**
+     * Creates a new ConstantFolder module for the provided tree.
+     */
+    explicit ConstantFolder(AST& tree);
+
+    /**
+     * Folds the body of every subroutine in the tree.
+     */
+    void run();
+
+private:
+    AST& ast;
+
+    void visit(NodeId node);
+    void simplify(NodeId node);
+    void simplifyUnary(NodeId node);
+    void simplifyBinary(NodeId node);
+
+    std::optional<std::int16_t> constantValue(NodeId node) const;
+    bool isPure(NodeId node) const;
+
+    void replaceWithConstant(NodeId node, std::int16_t value);
+    void replaceWithNode(NodeId node, NodeId replacement);
+    void replaceWithNegation(NodeId node, NodeId operand);
+};
+
+}
+
+#endif
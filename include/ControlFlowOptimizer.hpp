@@ -0,0 +1,101 @@
+#ifndef CONTROLFLOWOPTIMIZER_H
+#define CONTROLFLOWOPTIMIZER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Compiler {
+
+/**
+ * Counts of the control-flow simplifications applied to a class.
+ */
+struct FlowStats {
+    int unreachableBlocks { 0 };
+    int jumpsThreaded { 0 };
+    int blocksMerged { 0 };
+    int jumpsRemoved { 0 };
+};
+
+/*
+Sits in front of another VMWriter and rewrites each function through its control-flow graph. The commands of a
+function are held until the next function definition, then split into basic blocks at labels and after jumps.
+Jumps to a block that only jumps on are retargeted to the final destination, blocks not reachable from the entry
+are dropped, a block entered only by a goto is placed directly after that goto, jumps to the next block are
+removed, and the labels that are still referenced are renumbered from 0 in each function.
+*/
+class ControlFlowOptimizer : public VMWriter {
+public:
+    static constexpr int REVISION { 1 };
+
+    /**
+     * Creates a new ControlFlowOptimizer module that writes the optimized commands to the provided writer.
+     */
+    explicit ControlFlowOptimizer(std::unique_ptr<VMWriter> output);
+
+    /**
+     * Optimizes and writes the commands of the last function to the output writer.
+     */
+    ~ControlFlowOptimizer() override;
+
+    ControlFlowOptimizer(const ControlFlowOptimizer&) = delete;
+    ControlFlowOptimizer& operator=(const ControlFlowOptimizer&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Flushes the buffered commands and finishes the output writer.
+     */
+    void finish() override;
+
+    /**
+     * Optimizes and writes the buffered commands of the current function to the output writer.
+     */
+    void flush();
+
+    /**
+     * Returns the simplifications applied so far.
+     */
+    const FlowStats& getStats() const;
+
+private:
+    struct BasicBlock {
+        std::vector<int> labels;            // labels naming the block's first command
+        std::vector<VMInstruction> code;    // commands, ending with the block's jump or return, if any
+    };
+
+    std::unique_ptr<VMWriter> writer;
+    std::vector<VMInstruction> code;
+    std::vector<BasicBlock> blocks;
+    std::unordered_map<int, std::size_t> labelBlocks;
+    FlowStats stats;
+
+    void buildBlocks();
+    void mapLabels();
+    void threadJumps();
+    void removeUnreachableBlocks();
+    void layoutBlocks();
+    void removeRedundantJumps();
+    void writeBlocks();
+
+    std::size_t targetBlock(int label) const;
+    const VMInstruction* exitJump(const BasicBlock& block) const;
+    bool fallsThrough(const BasicBlock& block) const;
+};
+
+}
+
+#endif
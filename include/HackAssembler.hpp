@@ -0,0 +1,48 @@
+#ifndef HACKASSEMBLER_H
+#define HACKASSEMBLER_H
+
+#include "CompilerResources.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Compiler {
+
+/**
+ * Indicates the assembler has received an instruction it cannot encode, or a program that does not fit in ROM.
+ */
+class AssemblyError : public JackCompilerError {
+public:
+    AssemblyError(const std::string& reason);
+};
+
+class HackAssembler {
+public:
+    /**
+     * Creates a new HackAssembler module for the provided Hack assembly program, which must outlive the module.
+     */
+    HackAssembler(std::string_view program);
+
+    /**
+     * Assembles the program and returns it as .hack text: one 16-digit binary word per line.
+     * Labels are resolved in a first pass; other symbols become variables allocated from RAM address 16.
+     */
+    std::string assemble();
+
+private:
+    static constexpr std::uint16_t FIRST_VARIABLE { 16 };
+    static constexpr std::size_t ROM_SIZE { 32768 };
+
+    std::string_view source;
+    std::unordered_map<std::string_view, std::uint16_t> symbols;
+    std::uint16_t nextVariable;
+
+    std::uint16_t encodeAddress(std::string_view value);
+    std::uint16_t encodeCompute(std::string_view instruction);
+};
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef HACKWRITER_H
+#define HACKWRITER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Compiler {
+
+/**
+ * Hack assembly generated for a single class, with the functions it defines and calls so that the program can be
+ * checked for undefined functions when the classes are linked.
+ */
+struct AsmModule {
+    std::string code;
+    std::vector<Name> functions;
+    std::vector<Name> calls;
+};
+
+/**
+ * Indicates the classes of a program call a function that none of them define.
+ */
+class LinkError : public JackCompilerError {
+public:
+    LinkError(const std::string& functions);
+};
+
+/*
+Lowers VM commands directly to Hack assembly, using the standard VM memory layout (SP, LCL, ARG, THIS, THAT,
+temp at 5-12, statics as assembler variables named "<file>.<index>").
+Each command picks a template by its operands: constants 0 and 1 are stored without loading them into D, segment
+offsets up to SMALL_OFFSET are reached by incrementing A instead of adding the index, and directly addressed
+segments (temp, pointer, static) skip the base pointer entirely. Comparisons, calls and returns jump to shared
+routines emitted once per program by link, which keeps call sites short.
+*/
+class HackWriter : public VMWriter {
+public:
+    /**
+     * Creates a new HackWriter module that appends the assembly of one class to the provided module, resolving function
+     * names through the provided pool. The file name prefixes the class's static variables.
+     */
+    HackWriter(AsmModule& output, const InternPool& namePool, std::string_view fileName);
+
+    HackWriter(const HackWriter&) = delete;
+    HackWriter& operator=(const HackWriter&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Returns the complete program: bootstrap code that calls Sys.init, the shared routines, then the provided modules
+     * in order. Throws a LinkError naming every called function that no module defines.
+     */
+    static std::string link(const std::vector<const AsmModule*>& modules, const InternPool& namePool);
+
+private:
+    static constexpr int SMALL_OFFSET { 3 };
+    static constexpr int TEMP_BASE { 5 };
+
+    AsmModule& module;
+    std::string& out;
+    const InternPool& pool;
+    std::string fileName;
+    std::string_view currentFunction;
+    int returnCount;
+
+    void line(std::string_view text);
+    void appendInt(int value);
+    void loadAddress(int value);
+    void writeLabelName(int label);
+    void writeReturnLabel(int id);
+    void jumpToRoutine(std::string_view routine);
+
+    void pushD();
+    void popD();
+    bool isDirect(Segment segment) const;
+    void loadDirectAddress(Segment segment, int index);
+    void loadSegmentBase(Segment segment);
+};
+
+}
+
+#endif
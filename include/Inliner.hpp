@@ -0,0 +1,68 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "InternPool.hpp"
+#include "VMRecorder.hpp"
+#include "VMWriter.hpp"
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace Compiler {
+
+/**
+ * A function whose body replaced at least one call, with the number of call sites replaced.
+ */
+struct InlinedFunction {
+    Name name;
+    int callSites;
+};
+
+/*
+Replaces calls to small leaf functions with the functions' bodies across a whole recorded program. A function can
+be inlined when it makes no calls, ends with its only fall-through return, and does not touch statics (which belong
+to its own file), that, pointer 1 or temp. Its arguments and locals move to temp TEMP_BASE onwards, which no
+other code keeps live across a call, and its this/pointer 0 accesses move to that/pointer 1, which the compiler
+only sets right before use, so the caller's this survives. A method whose first command pushes its only argument
+takes the object straight from the stack. Labels are renumbered past the caller's, and an early return jumps to
+the end of the inlined body.
+*/
+class Inliner {
+public:
+    static constexpr int TEMP_BASE { 3 };
+    static constexpr int TEMP_COUNT { 5 };  // temp 3..7
+
+    /**
+     * Creates a new Inliner module for the provided functions of a program, inlining bodies of up to maxSize
+     * commands, excluding the final return.
+     */
+    Inliner(const std::vector<VMFunction*>& program, unsigned maxSize);
+
+    /**
+     * Inlines every eligible call site in the program.
+     */
+    void run();
+
+    /**
+     * Returns the inlined functions in the order they were first inlined.
+     */
+    const std::vector<InlinedFunction>& getInlined() const;
+
+private:
+    std::vector<VMFunction*> functions;
+    unsigned limit;
+    std::unordered_map<Name, const VMFunction*> candidates;
+    std::unordered_map<Name, std::size_t> inlinedIndex;
+    std::vector<InlinedFunction> inlined;
+
+    bool isInlinable(const VMFunction& function) const;
+    bool takesObjectFromStack(const VMFunction& callee, int nArgs) const;
+    bool fits(const VMFunction& callee, int nArgs) const;
+    void inlineCalls(VMFunction& caller);
+    void expand(const VMFunction& callee, int nArgs, int labelBase, std::vector<VMInstruction>& out) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef INTERNPOOL_H
+#define INTERNPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Compiler {
+
+/**
+ * Integer handle for an interned identifier. Equal names always have equal handles within the same pool.
+ */
+using Name = std::uint32_t;
+
+/**
+ * Names the compiler itself refers to. Every pool interns these first, so their handles are fixed.
+ */
+namespace BuiltinName {
+    constexpr Name THIS { 0 };
+    constexpr Name MATH_MULTIPLY { 1 };
+    constexpr Name MATH_DIVIDE { 2 };
+    constexpr Name MEMORY_ALLOC { 3 };
+    constexpr Name STRING_NEW { 4 };
+    constexpr Name STRING_APPENDCHAR { 5 };
+}
+
+class InternPool {
+public:
+    /**
+     * Creates a new InternPool module holding only the builtin names. All member functions may be called
+     * concurrently; lookups of existing names take a shared lock and only new names take an exclusive one.
+     */
+    InternPool();
+
+    InternPool(const InternPool&) = delete;
+    InternPool& operator=(const InternPool&) = delete;
+
+    /**
+     * Returns the handle of the provided string, adding it to the pool if it has not been seen before.
+     */
+    Name intern(std::string_view str);
+
+    /**
+     * Returns the handle of the qualified name "className.memberName", building the string only the first time
+     * the pair is seen.
+     */
+    Name qualify(Name className, Name memberName);
+
+    /**
+     * Returns the string of the provided handle, valid for the lifetime of the pool.
+     */
+    std::string_view str(Name name) const;
+
+    /**
+     * Returns the number of distinct names in the pool.
+     */
+    std::size_t size() const;
+
+private:
+    static constexpr std::size_t INITIAL_CAPACITY { 1024 };
+
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, Name> lookup;
+    std::unordered_map<std::uint64_t, Name> qualified;
+};
+
+}
+
+#endif
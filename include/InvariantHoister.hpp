@@ -0,0 +1,64 @@
+#ifndef INVARIANTHOISTER_H
+#define INVARIANTHOISTER_H
+
+#include "AST.hpp"
+
+#include <cstdint>
+#include <unordered_set>
+
+namespace Compiler {
+
+/*
+Moves loop-invariant subexpressions of a class AST out of while loops. An expression is invariant in a loop when
+it is built from constants and variables the loop never assigns; fields and statics additionally require that
+the loop makes no calls and stores to no array element, since either could change them: an array may point at
+this object or at any address, statics included. Array elements, string literals and division are never
+hoisted. Each maximal invariant unary or binary expression in the condition or body is computed once into a new
+local by a let placed just before the loop, and read from that local inside it. Inner loops are handled first, so
+an expression can move out of several nested loops one level at a time.
+*/
+class InvariantHoister {
+public:
+    static constexpr int REVISION { 1 };
+
+    /**
+     * Creates a new InvariantHoister module for the provided tree.
+     */
+    explicit InvariantHoister(AST& tree);
+
+    /**
+     * Hoists the invariant expressions out of every loop in the tree, adding locals to the subroutines as needed.
+     */
+    void run();
+
+    /**
+     * Returns the number of expressions hoisted.
+     */
+    int getHoisted() const;
+
+private:
+    /**
+     * What a single loop may change: the variables it assigns, and whether it makes calls or stores to arrays.
+     */
+    struct LoopEffects {
+        std::unordered_set<std::uint32_t> assigned;
+        bool hasCalls { false };
+        bool hasMemoryWrites { false };
+    };
+
+    AST& ast;
+    SubroutineDec* subroutine;
+    int hoisted;
+
+    void visitBlock(NodeId block);
+    void hoistFromLoop(NodeId block, NodeId previous, NodeId loop);
+    void collectEffects(NodeId node, LoopEffects& effects) const;
+    void replaceInvariants(NodeId node, const LoopEffects& effects, NodeId block, NodeId& previous);
+
+    bool isInvariant(NodeId node, const LoopEffects& effects) const;
+    static std::uint32_t variableKey(const Node& var);
+};
+
+}
+
+#endif
@@ -1,8 +1,19 @@
 #ifndef JACKCOMPILER_H
 #define JACKCOMPILER_H
 
+#include "CompilationEngine.hpp"
+#include "CompilerOptions.hpp"
+#include "HackWriter.hpp"
+#include "Inliner.hpp"
+#include "InternPool.hpp"
+#include "VMRecorder.hpp"
+
+#include <cstddef>
 #include <filesystem>
-#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace Compiler {
@@ -12,16 +23,42 @@ namespace fs = std::filesystem;
 class JackCompiler {
 public:
     /**
-     * Compiles all Jack files found in the provided source path into a corresponding VM file.
+     * Compiles all Jack files found in the provided source path into a corresponding VM file, up to
+     * options.jobs files at a time. An error in one file is reported without stopping the others.
+     * With options.useCache, files unchanged since their last successful compilation are skipped.
+     * Whole-program formats link every class into a single output file once all files compile.
+     * Inlining and pruning record every class in memory and write the output only once all files compile.
+     * Returns the number of files that failed to compile.
      */
-    void compile(const fs::path& sourceFile, bool debugMode);
+    std::size_t compile(const fs::path& sourceFile, const CompilerOptions& options);
 
 private:
+    /**
+     * Output of a single file's compilation, kept until all files finish so that it can be reported in file order.
+     */
+    struct FileResult {
+        std::ostringstream debugLog;
+        std::string error;
+        AsmModule assembly;     // whole-program formats only
+        std::vector<VMFunction> functions;  // whole-program analysis only; written once the program is known
+        OptimizationStats stats;
+    };
+
     static const fs::path DEBUG_FILE;
     std::vector<fs::path> files;
+    InternPool pool;
+
+    static fs::path outputPath(const fs::path& infile, OutputFormat format);
 
     void getJackFiles(const fs::path& dirname);
-    void compileFile(const fs::path& infile, const fs::path& outfile, std::ofstream* const debugFile) const;
+    void reportStats(const std::vector<std::size_t>& compiled, const std::vector<FileResult>& results) const;
+    void compileFile(const fs::path& infile, FileResult& result, const CompilerOptions& options);
+    bool writeProgram(const fs::path& sourceFile, std::vector<FileResult>& results, const CompilerOptions& options);
+    bool findReachable(const fs::path& sourceFile, const std::vector<VMFunction*>& program, std::unordered_set<Name>& reachable);
+    void reportInlined(const std::vector<InlinedFunction>& inlined) const;
+    std::unique_ptr<VMWriter> createWriter(const fs::path& infile, FileResult& result, const CompilerOptions& options);
+    bool linkProgram(const fs::path& sourceFile, const std::vector<FileResult>& results, const CompilerOptions& options);
+    void compileParallel(const std::vector<std::size_t>& pending, std::vector<FileResult>& results, const CompilerOptions& options);
 };
 
 }
@@ -0,0 +1,103 @@
+#ifndef JACKPARSER_H
+#define JACKPARSER_H
+
+#include "AST.hpp"
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "JackTokenizer.hpp"
+#include "SymbolTable.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+class JackParser {
+public:
+    /**
+     * Creates a new JackParser module to read the class in the provided file.
+     * Identifiers are interned into the provided pool, which may be shared by every file in a compilation run.
+     */
+    JackParser(const fs::path& infile, InternPool& namePool, std::ostream* const debugFile);
+
+    /**
+     * Parses the class into the provided AST, resolving every variable to its memory segment and index.
+     * String constants in the AST are views into the source and remain valid for the lifetime of the parser.
+     */
+    void parseClass(AST& tree);
+
+private:
+    // typical Jack source produces one AST node per 11 to 16 bytes; the reserve errs high, since capacity that is never
+    // used is never touched, while growing the arena would copy it
+    static constexpr std::size_t BYTES_PER_NODE { 8 };
+
+    InternPool& pool;
+    JackTokenizer tokenizer;
+    AST* ast;
+    Name currClassName;
+    std::vector<NodeId> pending;
+
+    SymbolTable classSymbols;
+    SymbolTable methodSymbols;
+
+    [[noreturn]] void handleInvalidToken(const Token& token, const TokenReq& req, const std::string* customReqName = nullptr) const;
+
+    bool compareToken(const Token& token, const TokenReq& req) const;
+    const Token& process(const TokenReq& req);
+    bool nextTokenIs(const TokenReq& req) const;
+    bool nextTokenIsOneOf(const TokenReqSet& reqs) const;
+
+    Keyword processKeyword();
+    Symbol processSymbol();
+    int processIntConst();
+    std::string_view processStringConst();
+    Name processIdentifier();
+
+    const Token& verifySet(const TokenReqSet& reqs, const std::string& setName);
+    const Token& verifyVarType();
+    const Token& verifyReturnType();
+
+    bool isClassVarDec() const;
+    bool isSubroutineDec() const;
+    bool isVarDec() const;
+    bool isStatement() const;
+
+    bool termIsSubroutineCall() const;
+    bool termIsArrayExp() const;
+
+    Name typeName(const Token& token);
+    const SymbolTable* getVarScope(Name name) const;
+    NodeId adoptPending(NodeId parent, std::size_t mark);
+
+    void parseClassVarDec();
+    void parseSubroutine();
+    void parseParameterList();
+    NodeId parseSubroutineBody();
+    void parseVarDec();
+    Name parseVarName(Name type, const Segment& segment, SymbolTable& symbolTable);
+    const SymbolTable::Entry* parseVarName();
+    NodeId addVarNode(const SymbolTable::Entry* entryPtr);
+    Name parseName();
+    NodeId parseSubroutineCall();
+    NodeId parseStatements();
+    NodeId parseLet();
+    NodeId parseIf();
+    NodeId parseWhile();
+    NodeId parseDo();
+    NodeId parseReturn();
+    NodeId parseExpression();
+    NodeId parseTerm();
+    void parseExpressionList();
+    NodeId parseKeywordConstTerm();
+    NodeId parseIdentifierTerm();
+};
+
+}
+
+#endif
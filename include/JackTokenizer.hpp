@@ -2,10 +2,13 @@
 #define JACKTOKENIZER_H
 
 #include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "SourceFile.hpp"
 
-#include <deque>
+#include <array>
+#include <cstddef>
 #include <filesystem>
-#include <regex>
+#include <string_view>
 
 namespace Compiler {
 
@@ -15,8 +18,10 @@ class JackTokenizer {
 public:
     /**
      * Creates a new JackTokenizer module to read tokens from the provided file.
+     * Tokens are produced on demand, so at most LOOKAHEAD tokens beyond the current one are held at any time.
+     * Identifier tokens carry their handle in the provided pool as their value.
      */
-    JackTokenizer(const fs::path& infilePath);
+    JackTokenizer(const fs::path& infilePath, InternPool& namePool);
 
     /**
      * Peeks the next token from input without advancing to it and processing the token.
@@ -38,17 +43,41 @@ public:
      */
     const Token& peekSecond() const;
 
+    /**
+     * Returns a view of the source text of the provided token, excluding the quotes of a string constant.
+     */
+    std::string_view text(const Token& token) const;
+
+    /**
+     * Returns the size of the source file in bytes.
+     */
+    std::size_t sourceSize() const;
+
 private:
-    static std::regex tokenPattern;
+    static constexpr std::size_t LOOKAHEAD { 2 };
+    static constexpr int MAX_INT_CONST { 32767 };
+
+    SourceFile source;
+    InternPool& pool;
+    const char* base;
+    const char* cursor;
+    const char* end;
 
-    std::string data;
     Token currToken;
-    std::deque<Token> tokens;
-    std::unordered_map<TokenType, std::function<void()>> tokenizeMap;
-    
-    static TokenType getTokenType(const std::string& tokenVal);
-    static Token tokenize(const std::string& tokenVal);
-    void matchTokens();
+    std::array<Token, LOOKAHEAD> window;
+    std::size_t head;
+    std::size_t count;
+
+    const Token& peek(std::size_t offset) const;
+    void fillWindow();
+
+    Token makeToken(TokenType type, std::uint32_t value, const char* begin, const char* last) const;
+    void skipBlockComment();
+    void matchIntConst(Token& token);
+    void matchStringConst(Token& token);
+    void matchWord(Token& token);
+    bool matchSymbol(Token& token);
+    bool matchToken(Token& token);
 };
 
 }
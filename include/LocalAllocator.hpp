@@ -0,0 +1,82 @@
+#ifndef LOCALALLOCATOR_H
+#define LOCALALLOCATOR_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Compiler {
+
+/*
+Sits in front of another VMWriter and reassigns the local slots of each function from a liveness analysis of its
+commands. A store to a local that is never read afterwards becomes a pop into scratch temp 0, locals that are then
+never referenced lose their slot, and locals whose live ranges do not overlap share one. Every slot is still zeroed
+on entry, so locals read before their first store, which are live on entry, keep their zero: they interfere with
+each other and with every store made while they are live. The function is written with the reduced local count.
+*/
+class LocalAllocator : public VMWriter {
+public:
+    static constexpr int REVISION { 1 };
+
+    /**
+     * Creates a new LocalAllocator module that writes the rewritten functions to the provided writer.
+     */
+    explicit LocalAllocator(std::unique_ptr<VMWriter> output);
+
+    /**
+     * Writes the last function to the output writer.
+     */
+    ~LocalAllocator() override;
+
+    LocalAllocator(const LocalAllocator&) = delete;
+    LocalAllocator& operator=(const LocalAllocator&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Flushes the buffered commands and finishes the output writer.
+     */
+    void finish() override;
+
+    /**
+     * Rewrites and writes the buffered function to the output writer.
+     */
+    void flush();
+
+    /**
+     * Returns the number of local slots removed from the functions written so far.
+     */
+    int getLocalsRemoved() const;
+
+private:
+    using LiveSet = std::vector<std::uint64_t>;
+
+    std::unique_ptr<VMWriter> writer;
+    bool hasFunction;
+    Name functionName;
+    int functionVars;
+    std::vector<VMInstruction> code;
+    int localsRemoved;
+
+    LiveSet analyzeLiveness(std::size_t words, LiveSet& entryLive) const;
+    std::vector<int> assignSlots(std::size_t words, const LiveSet& liveOut, const LiveSet& liveIn) const;
+    bool isLocal(const VMInstruction& instruction, VMOp op) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef PEEPHOLEOPTIMIZER_H
+#define PEEPHOLEOPTIMIZER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Compiler {
+
+/*
+Sits between CompilationEngine and another VMWriter and rewrites short instruction sequences as they are
+written. Commands are held until the next function definition; each new command is checked against a table of
+patterns ending at it, and a match is replaced in place before the next command arrives, so rewrites cascade.
+Patterns never span functions.
+*/
+class PeepholeOptimizer : public VMWriter {
+public:
+    static constexpr int REVISION { 1 };
+    static constexpr std::size_t RULE_COUNT { 15 };
+
+    /**
+     * Creates a new PeepholeOptimizer module that writes the optimized commands to the provided writer.
+     */
+    explicit PeepholeOptimizer(std::unique_ptr<VMWriter> output);
+
+    /**
+     * Writes the remaining commands to the output writer.
+     */
+    ~PeepholeOptimizer() override;
+
+    PeepholeOptimizer(const PeepholeOptimizer&) = delete;
+    PeepholeOptimizer& operator=(const PeepholeOptimizer&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Flushes the buffered commands and finishes the output writer.
+     */
+    void finish() override;
+
+    /**
+     * Writes all buffered commands to the output writer.
+     */
+    void flush();
+
+    /**
+     * Returns how many times each rule has been applied, indexed like ruleName.
+     */
+    const std::array<int, RULE_COUNT>& ruleHits() const;
+
+    /**
+     * Returns the short name of the rule with the provided index.
+     */
+    static std::string_view ruleName(std::size_t rule);
+
+private:
+    std::unique_ptr<VMWriter> writer;
+    std::vector<VMInstruction> code;
+    std::array<int, RULE_COUNT> hits;
+
+    void append(VMOp op, std::uint8_t detail, int arg, Name name = 0);
+    void reduce();
+};
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+class SourceFile {
+public:
+    /**
+     * Creates a new SourceFile module that maps the provided file into memory read-only.
+     * Falls back to reading the file into an owned buffer on platforms or files that cannot be mapped.
+     */
+    SourceFile(const fs::path& path);
+
+    /**
+     * Unmaps the file, invalidating every view previously returned by text().
+     */
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    /**
+     * Returns whether or not the file was opened successfully.
+     */
+    bool isOpen() const;
+
+    /**
+     * Returns a view of the entire file contents, valid for the lifetime of this object.
+     */
+    std::string_view text() const;
+
+private:
+    bool opened;
+    const char* mapped;
+    std::size_t size;
+    std::string buffer;
+
+    bool map(const fs::path& path);
+    bool read(const fs::path& path);
+};
+
+}
+
+#endif
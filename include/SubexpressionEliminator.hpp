@@ -0,0 +1,77 @@
+#ifndef SUBEXPRESSIONELIMINATOR_H
+#define SUBEXPRESSIONELIMINATOR_H
+
+#include "AST.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Compiler {
+
+/*
+Local value numbering over the expressions of each statement of a class AST. The expressions are walked in the
+order the code generator evaluates them; a pure unary, binary or array expression that is equal to one already
+evaluated in the same statement is rewritten in place into a read of a new local, and the earlier expression is
+recorded so that the code generator keeps a copy of its value in that local. A call invalidates the values that
+read fields, statics or array elements; locals and arguments cannot change within a statement. Array stores only
+happen once a let statement's expressions have all been evaluated, so they never fall between two uses. Only
+expressions costing enough commands to repay the copy are shared.
+*/
+class SubexpressionEliminator {
+public:
+    static constexpr int REVISION { 1 };
+
+    /**
+     * Creates a new SubexpressionEliminator module for the provided tree.
+     */
+    explicit SubexpressionEliminator(AST& tree);
+
+    /**
+     * Shares the repeated expressions of every statement in the tree, adding locals to the subroutines as needed.
+     */
+    void run();
+
+    /**
+     * Returns the expressions whose value is reused, each with the local that keeps a copy of it.
+     */
+    const std::unordered_map<NodeId, int>& getCachedValues() const;
+
+    /**
+     * Returns the number of expressions replaced by a read of an earlier value.
+     */
+    int getEliminated() const;
+
+private:
+    static constexpr int MIN_COST { 4 };    // commands an expression must cost to repay the pop and push of its copy
+
+    /**
+     * An expression evaluated earlier in the current statement.
+     */
+    struct Value {
+        NodeId node;
+        std::uint64_t hash;
+        bool readsMemory;
+    };
+
+    AST& ast;
+    SubroutineDec* subroutine;
+    std::vector<Value> available;
+    std::unordered_map<NodeId, int> cachedValues;
+    int eliminated;
+
+    void visitBlock(NodeId block);
+    void number(NodeId node);
+    void reuse(NodeId node, NodeId first);
+
+    bool isCandidate(NodeId node) const;
+    bool isPure(NodeId node) const;
+    bool readsMemory(NodeId node) const;
+    int cost(NodeId node) const;
+    std::uint64_t hash(NodeId node) const;
+    bool equal(NodeId a, NodeId b) const;
+};
+
+}
+
+#endif
@@ -2,10 +2,11 @@
 #define SYMBOLTABLE_H
 
 #include "CompilerResources.hpp"
+#include "InternPool.hpp"
 
 #include <filesystem>
 #include <fstream>
-#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 
@@ -19,26 +20,25 @@ public:
      * Models the value of a SymbolTable entry with its data type and memory segment and index.
      */
     struct Entry {
-        std::string type;
+        Name type;
         Segment segment;
         int index;
 
-        Entry(std::string t, Segment s, int i) : type(t), segment(s), index(i) {}
+        Entry(Name t, Segment s, int i) : type(t), segment(s), index(i) {}
         template <typename... Args>
         Entry(Args&&... args) : type(std::forward<Args>(args)...), segment(std::forward<Args>(args)...), index(std::forward<Args>(args)...) {}
-
-        friend std::ostream& operator<<(std::ostream& os, const Entry& entry);
     };
 
     /**
-     * Creates a new SymbolTable module, with an optional debug file to write the data in the symbol table to.
+     * Creates a new SymbolTable module that resolves names through the provided pool,
+     * with an optional debug file to write the data in the symbol table to.
      */
-    SymbolTable(std::ofstream* const debugFilePath);
+    SymbolTable(const InternPool& namePool, std::ostream* const debugFilePath);
 
     /**
      * Returns whether or not the provided symbol name exists in the symbol table.
      */
-    bool contains(const std::string& name) const;
+    bool contains(Name name) const;
 
     /**
      * Clears the symbol table.
@@ -49,13 +49,13 @@ public:
      * Adds a new entry to the symbol table with the provided name and properties,
      * using the next free index for the provided memory segment.
      */
-    void define(const std::string& name, const std::string& type, const Segment& segment);
+    void define(Name name, Name type, const Segment& segment);
 
     /**
      * Adds a new entry to the symbol table named "this" with the provided type.
      * Used to support object-oriented methods by passing this as the first argument to a method call.
      */
-    void defineThisObject(const std::string& type);
+    void defineThisObject(Name type);
 
     /**
      * Returns the number of variables in the provided memory segment in the symbol table.
@@ -65,32 +65,33 @@ public:
     /**
      * Returns a pointer to the entry of the provided symbol.
      */
-    const SymbolTable::Entry* getEntry(const std::string& name) const;
+    const SymbolTable::Entry* getEntry(Name name) const;
 
     /**
      * Returns the data type of the provided symbol.
      */
-    std::string typeOf(const std::string& name) const;
+    Name typeOf(Name name) const;
 
     /**
      * Returns the memory segment of the provided symbol.
      */
-    Segment segmentOf(const std::string& name) const;
+    Segment segmentOf(Name name) const;
 
     /**
      * Returns the memory index of the provided symbol.
      */
-    int indexOf(const std::string& name) const;
+    int indexOf(Name name) const;
 
     /**
-     * Writes the entire table to the debug file, if one was provided.
+     * Writes the entire table to the debug file, if one was provided, tagged with the provided scope name and kind.
      */
-    void dumpTable(const std::string& tag);
+    void dumpTable(Name scope, std::string_view kind);
 
 private:
-    std::unordered_map<std::string, SymbolTable::Entry> data;
+    const InternPool& pool;
+    std::unordered_map<Name, SymbolTable::Entry> data;
     std::unordered_map<Segment, int> counters;
-    std::ofstream* const debugFile;
+    std::ostream* const debugFile;
 };
 
 }
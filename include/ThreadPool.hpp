@@ -0,0 +1,67 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Compiler {
+
+class ThreadPool {
+public:
+    /**
+     * Creates a new ThreadPool module with the provided number of worker threads, each owning a task queue.
+     * Idle workers steal from the back of other workers' queues.
+     */
+    explicit ThreadPool(std::size_t nThreads);
+
+    /**
+     * Waits for all submitted tasks to finish, then stops and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Queues a task on the next worker in round-robin order. Workers run their own queue front to back,
+     * so tasks submitted in decreasing order of cost are started largest first. Tasks must not throw: an
+     * exception that escapes a task terminates the program.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Blocks until every submitted task has finished.
+     */
+    void wait();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::size_t queued;
+    std::size_t unfinished;
+    std::size_t nextQueue;
+    bool stopping;
+
+    bool popOwn(std::size_t self, std::function<void()>& task);
+    bool steal(std::size_t self, std::function<void()>& task);
+    void run(std::size_t self);
+};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef VMBINARYWRITER_H
+#define VMBINARYWRITER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+/**
+ * Indicates a VM command cannot be encoded in the binary VM format: an index that does not fit in 16 bits, or a
+ * jump to a label its function does not define.
+ */
+class EncodingError : public JackCompilerError {
+public:
+    EncodingError(const std::string& reason);
+};
+
+/**
+ * Opcodes of the binary VM format. The arithmetic opcodes follow the declaration order of Command.
+ */
+enum class VMBOpcode : std::uint8_t {
+    PUSH,
+    POP,
+    ADD, SUB, NEG, EQ, GT, LT, AND, OR, NOT,
+    LABEL,
+    GOTO,
+    IF_GOTO,
+    FUNCTION,
+    CALL,
+    RETURN
+};
+
+/*
+Binary VM (.vmb) layout. Every field is little-endian and every section starts on a 4-byte boundary, so a loader
+can map the file and index it in place.
+
+header:      u32 magic "VMB1", u32 version, u32 functionCount, u32 stringCount, u32 stringDataSize, u32 instructionCount
+functions:   functionCount x { u32 name (string id), u32 nLocals, u32 firstInstruction (index of its FUNCTION) }
+strings:     stringCount x u32 offset into the string data, then stringDataSize bytes of NUL-terminated strings
+             (padded with NULs to a multiple of 4)
+code:        instructionCount x 8-byte instructions { u8 opcode, u8 segment, u16 index, u32 operand }
+
+push/pop:            segment = Segment enum value, index = segment index
+arithmetic, return:  no operands
+label:               operand = string id of the label name "L<n>", shared by every label numbered n
+goto, if-goto:       operand = instruction index of the target label; labels are scoped to their function
+function:            operand = string id of the name, index = nLocals
+call:                operand = string id of the callee name, index = nArgs
+*/
+class VMBinaryWriter : public VMWriter {
+public:
+    static constexpr std::uint32_t MAGIC { 0x31424D56 };    // "VMB1"
+    static constexpr std::uint32_t VERSION { 1 };
+
+    /**
+     * Creates a new VMBinaryWriter module to write VM commands in the binary format to the provided file, resolving
+     * function names through the provided pool. Commands are collected in memory; labels are resolved and the file
+     * is written by finish, so no file is written after an error.
+     */
+    VMBinaryWriter(const fs::path& outfilePath, const InternPool& namePool);
+
+    VMBinaryWriter(const VMBinaryWriter&) = delete;
+    VMBinaryWriter& operator=(const VMBinaryWriter&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Resolves the jump targets of the last function and writes the whole file.
+     */
+    void finish() override;
+
+private:
+    struct Instruction {
+        VMBOpcode opcode;
+        std::uint8_t segment;
+        std::uint16_t index;
+        std::uint32_t operand;
+    };
+
+    struct Function {
+        std::uint32_t name;
+        std::uint32_t nLocals;
+        std::uint32_t firstInstruction;
+    };
+
+    static constexpr std::uint32_t NO_TARGET { UINT32_MAX };
+
+    fs::path outfile;
+    const InternPool& pool;
+
+    std::vector<Instruction> code;
+    std::vector<Function> functions;
+    std::vector<std::uint32_t> stringOffsets;
+    std::string stringData;
+    std::unordered_map<Name, std::uint32_t> nameStrings;
+    std::vector<std::uint32_t> labelStrings;    // string id of each label number, NO_TARGET until first written
+    std::vector<std::uint32_t> labelTargets;    // instruction index of each label number in the current function
+    std::size_t functionStart { 0 };            // first instruction of the current function
+
+    void add(VMBOpcode opcode, std::uint8_t segment, int index, std::uint32_t operand);
+    std::uint32_t addString(std::string_view str);
+    std::uint32_t nameString(Name name);
+    std::uint32_t labelString(int label);
+    void resolveLabels();
+    void writeFile();
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef VMRECORDER_H
+#define VMRECORDER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <vector>
+
+namespace Compiler {
+
+/**
+ * The VM commands of a single function, held in memory.
+ */
+struct VMFunction {
+    Name name;
+    int nVars;
+    std::vector<VMInstruction> code;
+};
+
+/*
+Records VM commands in memory instead of writing them, one VMFunction per function definition, so that a later
+pass can decide which functions to write and replay them into another VMWriter.
+*/
+class VMRecorder : public VMWriter {
+public:
+    /**
+     * Creates a new VMRecorder module that appends each recorded function to the provided list.
+     */
+    explicit VMRecorder(std::vector<VMFunction>& output);
+
+    VMRecorder(const VMRecorder&) = delete;
+    VMRecorder& operator=(const VMRecorder&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Writes the provided recorded function, including its definition, to the provided writer.
+     */
+    static void replay(const VMFunction& function, VMWriter& writer);
+
+private:
+    std::vector<VMFunction>& functions;
+
+    void append(const VMInstruction& instruction);
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef VMTEXTWRITER_H
+#define VMTEXTWRITER_H
+
+#include "CompilerResources.hpp"
+#include "InternPool.hpp"
+#include "VMWriter.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+class VMTextWriter : public VMWriter {
+public:
+    /**
+     * Creates a new VMTextWriter module to write VM commands as text to the provided file, resolving function names through the provided pool.
+     * Commands are formatted into an in-memory buffer that is written to the file in large blocks.
+     */
+    VMTextWriter(const fs::path& outfilePath, const InternPool& namePool);
+
+    /**
+     * Writes any buffered commands to the file.
+     */
+    ~VMTextWriter() override;
+
+    VMTextWriter(const VMTextWriter&) = delete;
+    VMTextWriter& operator=(const VMTextWriter&) = delete;
+
+    void writePush(const Segment& segment, const int index) override;
+    void writePop(const Segment& segment, const int index) override;
+    void writeArithmetic(const Command& command) override;
+    void writeLabel(const int label) override;
+    void writeGoto(const int label) override;
+    void writeIf(const int label) override;
+    void writeCall(Name name, const int nArgs) override;
+    void writeFunction(Name name, const int nVars) override;
+    void writeReturn() override;
+
+    /**
+     * Writes all buffered commands to the file.
+     */
+    void flush();
+
+private:
+    static constexpr std::size_t BUFFER_SIZE { 1 << 16 };
+    static constexpr std::size_t MAX_COMMAND_SIZE { 32 };   // longest command other than the name in a call/function
+
+    std::ofstream outfile;
+    const InternPool& pool;
+    std::string buffer;
+
+    void ensureSpace(std::size_t size);
+    void append(std::string_view str);
+    void appendInt(int value);
+};
+
+}
+
+#endif
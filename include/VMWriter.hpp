@@ -1,68 +1,117 @@
 #ifndef VMWRITER_H
 #define VMWRITER_H
 
+#include "CompilerOptions.hpp"
 #include "CompilerResources.hpp"
+#include "InternPool.hpp"
 
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
-#include <string>
+#include <memory>
 
 namespace Compiler {
 
 namespace fs = std::filesystem;
 
+/**
+ * Kinds of VM command, as buffered by the optimizing writers.
+ */
+enum class VMOp : std::uint8_t {
+    PUSH,
+    POP,
+    ARITHMETIC,
+    LABEL,
+    GOTO,
+    IF,
+    CALL,
+    RETURN
+};
+
+/**
+ * A VM command held in memory. detail holds the Segment of a push/pop or the Command of an arithmetic command; arg
+ * holds the index, label number or argument count.
+ */
+struct VMInstruction {
+    VMOp op;
+    std::uint8_t detail;
+    int arg;
+    Name name;
+};
+
 class VMWriter {
 public:
     /**
-     * Creates a new VMWriter module to write VM commands to the provided file.
+     * Creates the VMWriter module for the provided per-class output format, writing to the provided file and
+     * resolving function names through the provided pool.
+     */
+    static std::unique_ptr<VMWriter> create(const fs::path& outfilePath, const InternPool& namePool, OutputFormat format);
+
+    /**
+     * Returns the file extension, including the dot, of files written in the provided output format.
+     */
+    static const char* extension(OutputFormat format);
+
+    /**
+     * Releases the writer. An output file that finish has not completed may be incomplete or missing.
      */
-    VMWriter(const fs::path& outfilePath) : outfile(outfilePath) {}
+    virtual ~VMWriter() = default;
+
+    /**
+     * Writes any commands still held back and completes the output file. Throws a JackCompilerError if the commands
+     * cannot be written in the output format, which the destructor would not be able to report.
+     */
+    virtual void finish() {}
 
     /**
      * Writes a VM push command with the provided memory segment and index to output.
      */
-    void writePush(const Segment& segment, const int index);
+    virtual void writePush(const Segment& segment, const int index) = 0;
 
     /**
      * Writes a VM pop command with the provided memory segment and index to output.
      */
-    void writePop(const Segment& segment, const int index);
+    virtual void writePop(const Segment& segment, const int index) = 0;
 
     /**
      * Writes a VM arithmetic command with the provided operation to output.
      */
-    void writeArithmetic(const Command& command);
+    virtual void writeArithmetic(const Command& command) = 0;
 
     /**
-     * Writes a VM label command with the provided label to output.
+     * Writes a VM label command with the provided label number to output.
      */
-    void writeLabel(const std::string& label);
+    virtual void writeLabel(const int label) = 0;
 
     /**
-     * Writes a VM goto command with the provided label to output.
+     * Writes a VM goto command with the provided label number to output.
      */
-    void writeGoto(const std::string& label);
+    virtual void writeGoto(const int label) = 0;
 
     /**
-     * Writes a VM if-goto command with the provided label to output.
+     * Writes a VM if-goto command with the provided label number to output.
      */
-    void writeIf(const std::string& label);
+    virtual void writeIf(const int label) = 0;
 
     /**
      * Writes a VM function call command with the provided name and number of arguments to output.
      */
-    void writeCall(const std::string& name, const int nArgs);
+    virtual void writeCall(Name name, const int nArgs) = 0;
 
     /**
      * Writes a VM function definition command with the provided name and number of local variables to output.
      */
-    void writeFunction(const std::string& name, const int nVars);
+    virtual void writeFunction(Name name, const int nVars) = 0;
 
     /**
      * Writes a VM function return comamnd to output.
      */
-    void writeReturn();
-    
+    virtual void writeReturn() = 0;
+
+    /**
+     * Writes the provided buffered VM command to output.
+     */
+    void write(const VMInstruction& instruction);
+
     /**
      * Writes a VM push command with the provided integer constant to output.
      */
@@ -87,9 +136,6 @@ public:
      * Writes the VM command "pop pointer 1" to output.
      */
     void writePopThatPtr();
-
-private:
-    std::ofstream outfile;
 };
 
 }
@@ -1,14 +1,22 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "CompilerOptions.hpp"
+
 #include <string>
 
 namespace Compiler {
 
 /**
- * Validates the command-line arguments and flags provided in the executable call.
+ * Largest function body, in VM commands, inlined by --inline without an explicit limit.
  */
-bool isValidArguments(const int argc, const char* const argv[]);
+inline constexpr unsigned DEFAULT_INLINE_LIMIT { 12 };
+
+/**
+ * Validates the command-line arguments and flags provided in the executable call, storing the selected flags
+ * in the provided options. The source path is always the first argument.
+ */
+bool parseArguments(const int argc, const char* const argv[], CompilerOptions& options);
 
 /**
  * Displays an error message showing the correct usage of the compiler.
@@ -16,14 +24,25 @@ bool isValidArguments(const int argc, const char* const argv[]);
 void displayUsage();
 
 /**
- * Removes C++/Java-style single- and multi-line comments from the provided string in place.
+ * Returns whether or not the provided character is a decimal digit.
+ */
+inline bool isDigit(char chr) {
+    return chr >= '0' && chr <= '9';
+}
+
+/**
+ * Returns whether or not the provided character can begin an identifier.
  */
-void removeComments(std::string& text);
+inline bool isIdentifierStart(char chr) {
+    return (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z') || chr == '_';
+}
 
 /**
- * Returns whether or not every character in the provided string is a numeric character.
+ * Returns whether or not the provided character can continue an identifier.
  */
-bool strIsDigit(const std::string& str);
+inline bool isIdentifierChar(char chr) {
+    return isIdentifierStart(chr) || isDigit(chr);
+}
 
 }
 
@@ -0,0 +1,74 @@
+#include "AST.hpp"
+#include "CompilerResources.hpp"
+
+#include <string>
+
+namespace Compiler {
+
+void AST::reserve(std::size_t nodeCount) {
+    nodes.reserve(nodeCount);
+}
+
+NodeId AST::addNode(NodeKind kind, std::uint8_t op, std::uint32_t value) {
+    if (nodes.size() >= NO_NODE) {
+        throw JackCompilerError("Class has more than " + std::to_string(NO_NODE) + " syntax tree nodes");
+    }
+
+    NodeId id { static_cast<NodeId>(nodes.size()) };
+    nodes.push_back(Node { value, NO_NODE, op, NO_NODE, kind });
+    return id;
+}
+
+void AST::adopt(NodeId parent, const NodeId* first, const NodeId* last) {
+    if (first == last) {
+        nodes[parent].firstChild = NO_NODE;
+        return;
+    }
+
+    nodes[parent].firstChild = *first;
+    for (const NodeId* it = first + 1; it != last; ++it) {
+        nodes[*(it - 1)].nextSibling = *it;
+    }
+    nodes[*(last - 1)].nextSibling = NO_NODE;
+}
+
+void AST::adopt(NodeId parent, std::initializer_list<NodeId> children) {
+    adopt(parent, children.begin(), children.end());
+}
+
+std::uint32_t AST::addString(std::string_view str) {
+    strings.push_back(str);
+    return static_cast<std::uint32_t>(strings.size() - 1);
+}
+
+std::string_view AST::string(std::uint32_t index) const {
+    return strings[index];
+}
+
+NodeId AST::child(NodeId node, int n) const {
+    NodeId id { nodes[node].firstChild };
+    for (; id != NO_NODE && n > 0; --n) {
+        id = nodes[id].nextSibling;
+    }
+    return id;
+}
+
+int AST::childCount(NodeId node) const {
+    int count { 0 };
+    for (NodeId id = nodes[node].firstChild; id != NO_NODE; id = nodes[id].nextSibling) {
+        ++count;
+    }
+    return count;
+}
+
+std::size_t AST::size() const {
+    return nodes.size();
+}
+
+void AST::clear() {
+    nodes.clear();
+    strings.clear();
+    subroutines.clear();
+}
+
+}
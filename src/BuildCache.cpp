@@ -0,0 +1,132 @@
+#include "BuildCache.hpp"
+#include "CompilationEngine.hpp"
+#include "ConstantFolder.hpp"
+#include "ControlFlowOptimizer.hpp"
+#include "InvariantHoister.hpp"
+#include "LocalAllocator.hpp"
+#include "PeepholeOptimizer.hpp"
+#include "SourceFile.hpp"
+#include "SubexpressionEliminator.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+const fs::path BuildCache::CACHE_FILE { ".jackcache" };
+
+/*
+The REVISION of every module that shapes the generated code: the code generator and each optimization pass. All of
+them are part of the cache key, so a module whose output changes only bumps its own constant to keep the outputs of
+earlier compilers from being reused. A new pass declares a REVISION and is listed here.
+*/
+static constexpr int CODEGEN_REVISIONS[] {
+    CompilationEngine::REVISION,
+    ConstantFolder::REVISION,
+    PeepholeOptimizer::REVISION,
+    ControlFlowOptimizer::REVISION,
+    LocalAllocator::REVISION,
+    InvariantHoister::REVISION,
+    SubexpressionEliminator::REVISION,
+};
+
+static constexpr std::uint64_t HASH_SEED { 0xcbf29ce484222325 };
+static constexpr std::uint64_t HASH_PRIME { 0x100000001b3 };
+
+/*
+FNV-1a over 8-byte words instead of single bytes. Each step is a bijection of the running hash, so two inputs
+that differ in a single word always hash differently; the final mix spreads the last words over every bit.
+*/
+static std::uint64_t hashBytes(std::string_view data, std::uint64_t hash) {
+    std::size_t i { 0 };
+    for (; i + sizeof(std::uint64_t) <= data.size(); i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, data.data() + i, sizeof(word));
+        hash = (hash ^ word) * HASH_PRIME;
+    }
+    for (; i < data.size(); ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * HASH_PRIME;
+    }
+
+    hash ^= data.size();
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccd;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+BuildCache::BuildCache(const fs::path& dirname, const CompilerOptions& options) :
+    directory(dirname) {
+    // flags that change the generated code belong in the configuration; debugMode, jobs and useCache do not
+    std::ostringstream config;
+    config << COMPILER_VERSION << " codegen=";
+    for (int revision : CODEGEN_REVISIONS) {
+        config << revision << '.';
+    }
+    config << " emit=" << static_cast<int>(options.format) << " O=" << options.optimize << " pool=" << options.poolStrings;
+    configHash = hashBytes(config.str(), HASH_SEED);
+
+    load();
+}
+
+std::uint64_t BuildCache::key(const fs::path& infile) const {
+    SourceFile source(infile);
+    if (!source.isOpen()) { return 0; }
+
+    std::uint64_t hash { hashBytes(source.text(), configHash) };
+    return hash == 0 ? 1 : hash;
+}
+
+bool BuildCache::isFresh(const fs::path& infile, const fs::path& outfile, std::uint64_t key) const {
+    auto it { entries.find(infile.filename().string()) };
+    if (key == 0 || it == entries.end() || it->second.key != key) {
+        return false;
+    }
+
+    std::error_code error;
+    std::uintmax_t outputSize { fs::file_size(outfile, error) };
+    return !error && outputSize == it->second.outputSize;
+}
+
+void BuildCache::update(const fs::path& infile, const fs::path& outfile, std::uint64_t key) {
+    std::error_code error;
+    std::uintmax_t outputSize { fs::file_size(outfile, error) };
+    if (key == 0 || error) { return; }
+
+    entries[infile.filename().string()] = Entry { key, outputSize };
+}
+
+void BuildCache::save() const {
+    std::ofstream file(directory / CACHE_FILE);
+    if (!file) { return; }
+
+    file << CACHE_HEADER << '\n';
+    for (const std::pair<const std::string, Entry>& pair : entries) {
+        std::error_code error;
+        if (!fs::exists(directory / pair.first, error)) { continue; }
+
+        file << std::hex << pair.second.key << std::dec << ' ' << pair.second.outputSize << ' ' << pair.first << '\n';
+    }
+}
+
+// format: a header line, then one "<key in hex> <output size> <source filename>" line per entry
+void BuildCache::load() {
+    std::ifstream file(directory / CACHE_FILE);
+    std::string line;
+    if (!std::getline(file, line) || line != CACHE_HEADER) { return; }
+
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        std::string filename;
+
+        if (fields >> std::hex >> entry.key >> std::dec >> entry.outputSize && fields.get() == ' ' && std::getline(fields, filename)) {
+            entries[filename] = entry;
+        }
+    }
+}
+
+}
@@ -1,19 +1,19 @@
 #include "CompilationEngine.hpp"
+#include "AST.hpp"
 #include "CompilerResources.hpp"
-#include "JackTokenizer.hpp"
-#include "SymbolTable.hpp"
+#include "ConstantFolder.hpp"
+#include "ControlFlowOptimizer.hpp"
+#include "InvariantHoister.hpp"
+#include "JackParser.hpp"
+#include "LocalAllocator.hpp"
+#include "PeepholeOptimizer.hpp"
+#include "SubexpressionEliminator.hpp"
 #include "VMWriter.hpp"
 
 namespace Compiler {
 
 namespace fs = std::filesystem;
 
-const std::string CompilationEngine::MATH_MULTIPLY = "Math.multiply";
-const std::string CompilationEngine::MATH_DIVIDE = "Math.divide";
-const std::string CompilationEngine::MEMORY_ALLOC = "Memory.alloc";
-const std::string CompilationEngine::STRING_NEW = "String.new";
-const std::string CompilationEngine::STRING_APPENDCHAR = "String.appendChar";
-
 const std::unordered_map<Symbol, Command> CompilationEngine::commandLookup {
     {Symbol::PLUS, Command::ADD},
     {Symbol::MINUS, Command::SUB},
@@ -24,521 +24,570 @@ const std::unordered_map<Symbol, Command> CompilationEngine::commandLookup {
     {Symbol::VERTICAL_BAR, Command::OR}
 };
 
-const std::unordered_map<Symbol, std::string> CompilationEngine::mathLookup {
-    {Symbol::STAR, CompilationEngine::MATH_MULTIPLY},
-    {Symbol::SLASH, CompilationEngine::MATH_DIVIDE}
+const std::unordered_map<Symbol, Name> CompilationEngine::mathLookup {
+    {Symbol::STAR, BuiltinName::MATH_MULTIPLY},
+    {Symbol::SLASH, BuiltinName::MATH_DIVIDE}
 };
 
-CompilationEngine::CompilationEngine(const fs::path& infile, const fs::path& outfile, std::ofstream* const debugFile) :
-    tokenizer(infile),
-    writer(outfile),
+CompilationEngine::CompilationEngine(const fs::path& infile, std::unique_ptr<VMWriter> vmWriter, InternPool& namePool, const CompilerOptions& options, std::ostream* const debugFile) :
+    parser(infile, namePool, debugFile),
+    writer(std::move(vmWriter)),
+    pool(namePool),
     labelCount(0),
-    classSymbols(debugFile),
-    methodSymbols(debugFile) { compileClass(); }
+    optimize(options.optimize),
+    poolStrings(options.poolStrings),
+    stringInitName(0) {
+    parser.parseClass(ast);
+
+    if (optimize) {
+        ConstantFolder(ast).run();
+
+        InvariantHoister hoister(ast);
+        hoister.run();
+        stats.invariantsHoisted = hoister.getHoisted();
+
+        SubexpressionEliminator eliminator(ast);
+        eliminator.run();
+        cachedValues = eliminator.getCachedValues();
+        stats.subexpressionsReused = eliminator.getEliminated();
+    }
 
-// 'class' className '{' classVarDec* subroutineDec* '}'
-void CompilationEngine::compileClass() {
-    process(Keyword::CLASS);
-    currClassName = compileName();
-    process(Symbol::CURLBRACE_L);
-    while (isClassVarDec()) { compileClassVarDec(); }
-    while (isSubroutineDec()) { compileSubroutine(); }
-    process(Symbol::CURLBRACE_R);
+    if (poolStrings) {
+        for (const SubroutineDec& subroutine : ast.subroutines) {
+            bool usesStrings { false };
+            collectStrings(subroutine.body, usesStrings);
+            subroutineUsesStrings.push_back(usesStrings);
+        }
+        stringInitName = pool.qualify(ast.className, pool.intern(STRING_INIT_FUNCTION));
+        stats.stringsPooled = static_cast<int>(pooledStrings.size());
+    }
 
-    classSymbols.dumpTable(currClassName + " class");
-}
+    // -O: commands pass through the peephole, control-flow and local allocation stages on their way to the output
+    PeepholeOptimizer* peephole { nullptr };
+    ControlFlowOptimizer* flow { nullptr };
+    LocalAllocator* locals { nullptr };
+    if (optimize) {
+        auto localAllocator { std::make_unique<LocalAllocator>(std::move(writer)) };
+        locals = localAllocator.get();
+        auto flowOptimizer { std::make_unique<ControlFlowOptimizer>(std::move(localAllocator)) };
+        flow = flowOptimizer.get();
+        auto peepholeOptimizer { std::make_unique<PeepholeOptimizer>(std::move(flowOptimizer)) };
+        peephole = peepholeOptimizer.get();
+        writer = std::move(peepholeOptimizer);
+    }
 
-void CompilationEngine::handleInvalidToken(const Token& token, const TokenReq& req, const std::string* customReqName) {
-    std::string reqName { customReqName ? *customReqName : reqToString(req) };
+    compileClass();
+    writer->finish();
 
-    if (std::holds_alternative<TokenVal>(req)) {
-        throw TokenError(reqToString(token.val), reqName);
-    } else {
-        throw WildcardTokenError(reqToString(token.type), reqName);
+    if (optimize) {
+        stats.peepholeHits = peephole->ruleHits();
+        stats.flow = flow->getStats();
+        stats.localsRemoved = locals->getLocalsRemoved();
     }
 }
 
-std::string CompilationEngine::getLabel() {
-    return "L" + std::to_string(labelCount++);
+const OptimizationStats& CompilationEngine::getStats() const {
+    return stats;
 }
 
-std::pair<std::string, std::string> CompilationEngine::getLabelPair() {
-    return {getLabel(), getLabel()};
+int CompilationEngine::getLabel() {
+    return labelCount++;
 }
 
-bool CompilationEngine::compareToken(const Token& token, const TokenReq& req) const {
-    if (std::holds_alternative<TokenVal>(req)) {
-        return token.val == std::get<TokenVal>(req);
-    } else {
-        return token.type == std::get<TokenType>(req);
-    }
-}
-
-TokenVal CompilationEngine::process(const TokenReq& req) {
-    Token token { tokenizer.advance() };
-    if (compareToken(token, req)) {
-        return token.val;
-    }
-
-    handleInvalidToken(token, req);
+std::pair<int, int> CompilationEngine::getLabelPair() {
+    return {getLabel(), getLabel()};
 }
 
-const TokenReq* CompilationEngine::compareTokens(const Token& token, const std::vector<TokenReq>& reqsList) const {
-    for (const TokenReq& req : reqsList) {
-        if (compareToken(token, req)) {
-            return &req;
+/*
+String pooling: each distinct literal of the class gets a static after the class's own statics, and every use is
+a single push of that static. The statics are filled by a generated "<class>.$initStrings" function. Every
+subroutine that uses a literal calls it on entry unless the first pooled static is already set, so the literals
+are built once, the first time any of those subroutines runs.
+*/
+void CompilationEngine::collectStrings(NodeId node, bool& usesStrings) {
+    if (ast[node].kind == NodeKind::STRING_CONST) {
+        usesStrings = true;
+        std::string_view str { ast.string(ast[node].value) };
+        if (stringSlots.emplace(str, ast.nStatics + static_cast<int>(pooledStrings.size())).second) {
+            pooledStrings.push_back(str);
         }
     }
 
-    return nullptr;
-}
-
-bool CompilationEngine::nextTokenIs(const TokenReq& req) const {
-    return compareToken(tokenizer.nextToken(), req);
-}
-
-const TokenReq* CompilationEngine::nextTokenIsOneOf(const std::vector<TokenReq>& reqsList) const {
-    return compareTokens(tokenizer.nextToken(), reqsList);
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        collectStrings(child, usesStrings);
+    }
 }
 
-Keyword CompilationEngine::processKeyword() {
-    return std::get<Keyword>( process(TokenType::KEYWORD) );
-}
+void CompilationEngine::compileStringPoolGuard() {
+    int readyLabel { getLabel() };
 
-Symbol CompilationEngine::processSymbol() {
-    return std::get<Symbol>( process(TokenType::SYMBOL) );
+    writer->writePush(Segment::STATIC, ast.nStatics);
+    writer->writeIf(readyLabel);
+    writer->writeCall(stringInitName, 0);
+    writer->writePop(Segment::TEMP, 0);
+    writer->writeLabel(readyLabel);
 }
 
-int CompilationEngine::processIntConst() {
-    return std::get<int>( process(TokenType::INT_CONST) );
-}
+void CompilationEngine::compileStringPoolInit() {
+    writer->writeFunction(stringInitName, 0);
 
-std::string CompilationEngine::processStringConst() {
-    return std::get<std::string>( process(TokenType::STRING_CONST) );
-}
+    for (std::string_view str : pooledStrings) {
+        compileNewString(str);
+        writer->writePop(Segment::STATIC, stringSlots.at(str));
+    }
 
-std::string CompilationEngine::processIdentifier() {
-    return std::get<std::string>( process(TokenType::IDENTIFIER) );
+    writer->writeConstant(0);
+    writer->writeReturn();
 }
 
-TokenVal CompilationEngine::verifySet(const std::vector<TokenReq>& reqsList, const std::string& setName) {
-    if (const TokenReq* reqPtr = nextTokenIsOneOf(reqsList)) {
-        return process(*reqPtr);
+void CompilationEngine::compileClass() {
+    for (std::size_t i = 0; i < ast.subroutines.size(); ++i) {
+        compileSubroutine(ast.subroutines[i], poolStrings && subroutineUsesStrings[i]);
     }
 
-    handleInvalidToken(tokenizer.nextToken(), reqsList[0], &setName);
+    if (!pooledStrings.empty()) {
+        compileStringPoolInit();
+    }
 }
 
-TokenVal CompilationEngine::verifyVarType() {
-    return verifySet(TokenSet::DATA_TYPES, "var type");
+void CompilationEngine::compileSubroutine(const SubroutineDec& subroutine, const bool initStrings) {
+    compileFunctionHeader(subroutine);
+    if (initStrings) {
+        compileStringPoolGuard();
+    }
+    compileStatements(subroutine.body);
 }
 
-TokenVal CompilationEngine::verifyReturnType() {
-    return verifySet(TokenSet::RETURN_TYPES, "return type");
+/*
+constructor: push # field vars, alloc, then pop address to THIS ptr
+method: pop this address (first arg) to THIS ptr
+function: no extra setup
+*/
+void CompilationEngine::compileFunctionHeader(const SubroutineDec& subroutine) {
+    writer->writeFunction(subroutine.name, subroutine.nLocals);
+
+    if (subroutine.kind == Keyword::CONSTRUCTOR) {
+        writer->writeConstant(ast.nFields);
+        writer->writeCall(BuiltinName::MEMORY_ALLOC, 1);
+        writer->writePopThisPtr();
+    } else if (subroutine.kind == Keyword::METHOD) {
+        // this is always the first argument of a method
+        writer->writePush(Segment::ARG, 0);
+        writer->writePopThisPtr();
+    }
 }
 
-bool CompilationEngine::isClassVarDec() const {
-    return nextTokenIsOneOf(TokenSet::CLASS_VAR_DEC);
-}
+// arguments, including the receiver of a method call, are pushed in order before the call
+void CompilationEngine::compileSubroutineCall(NodeId call) {
+    int nArgs { 0 };
+    for (NodeId arg = ast[call].firstChild; arg != NO_NODE; arg = ast[arg].nextSibling) {
+        compileExpression(arg);
+        ++nArgs;
+    }
 
-bool CompilationEngine::isSubroutineDec() const {
-    return nextTokenIsOneOf(TokenSet::SUBROUTINE_DEC);
+    writer->writeCall(ast[call].value, nArgs);
 }
 
-bool CompilationEngine::isVarDec() const {
-    return nextTokenIs(Keyword::VAR);
+void CompilationEngine::compileStatements(NodeId block) {
+    for (NodeId statement = ast[block].firstChild; statement != NO_NODE; statement = ast[statement].nextSibling) {
+        switch (ast[statement].kind) {
+            case NodeKind::LET:    compileLet(statement);    break;
+            case NodeKind::IF:     compileIf(statement);     break;
+            case NodeKind::WHILE:  compileWhile(statement);  break;
+            case NodeKind::DO:     compileDo(statement);     break;
+            case NodeKind::RETURN: compileReturn(statement); break;
+            default: break;
+        }
+    }
 }
 
-bool CompilationEngine::isStatement() const {
-    return nextTokenIsOneOf(TokenSet::STATEMENTS);
-}
+void CompilationEngine::compileLet(NodeId let) {
+    NodeId target { ast.child(let, 0) };
+    NodeId value { ast.child(let, 1) };
 
-bool CompilationEngine::termIsSubroutineCall() const {
-    return compareTokens(tokenizer.peekSecond(), TokenSet::SUBROUTINE_CALL);
-}
+    if (ast[target].kind == NodeKind::ARRAY_ELEM) {
+        int offset { compileArrayAddress(target) };
 
-bool CompilationEngine::termIsArrayExp() const {
-    return compareToken(tokenizer.nextToken(), Symbol::SQRBRACK_L);
-}
+        // -O: a value that leaves pointer 1 alone is computed straight into place, without the temp 0 round-trip
+        if (optimize && preservesThatPointer(value)) {
+            writer->writePopThatPtr();
+            compileExpression(value);
+        } else {
+            compileExpression(value);
 
-const SymbolTable* CompilationEngine::getVarScope(const std::string& name) const {
-    if (methodSymbols.contains(name)) {
-        return &methodSymbols;
-    } else if (classSymbols.contains(name)) {
-        return &classSymbols;
+            writer->writePop(Segment::TEMP, 0);
+            writer->writePopThatPtr();
+            writer->writePush(Segment::TEMP, 0);
+        }
+        writer->writePop(Segment::THAT, offset);
     } else {
-        return nullptr;
+        compileExpression(value);
+        writer->writePop(ast[target].segment(), ast[target].value);
     }
 }
 
-// ( 'static' | 'field' ) type varName ( ',' varName )* ';'
-void CompilationEngine::compileClassVarDec() {
-    Segment symbolSegment { keywordToSegment( processKeyword() ) };
-    std::string symbolType { reqToString( verifyVarType() ) };
+void CompilationEngine::compileIf(NodeId ifNode) {
+    auto [ifLabel, gotoLabel] { getLabelPair() };
 
-    while (true) {
-        compileVarName(symbolType, symbolSegment, classSymbols);
-        if (!nextTokenIs(Symbol::COMMA)) { break; }
-        process(Symbol::COMMA);
-    }
-    process(Symbol::SEMICOLON);
-}
+    NodeId condition { ast.child(ifNode, 0) };
+    NodeId elseBlock { ast.child(ifNode, 2) };
 
-// ( 'constructor' | 'function' | 'method' ) ( 'void' | type ) subroutineName '(' parameterList ')' subroutineBody
-void CompilationEngine::compileSubroutine() {
-    Keyword subroutineType { processKeyword() };
-    verifyReturnType();
-    std::string subroutineName { compileName() };
+    // -O: a boolean condition branches straight to the then block, which is placed after the else block
+    if (optimize && elseBlock != NO_NODE && isBoolean(condition)) {
+        compileExpression(condition);
+        writer->writeIf(ifLabel);
 
-    methodSymbols.reset();
-    // methods take this object as implicit first argument
-    if (subroutineType == Keyword::METHOD) { methodSymbols.defineThisObject(currClassName); }
+        compileStatements(elseBlock);
 
-    process(Symbol::PAREN_L);
-    compileParameterList();
-    process(Symbol::PAREN_R);
-    compileSubroutineBody(subroutineName, subroutineType);
+        writer->writeGoto(gotoLabel);
+        writer->writeLabel(ifLabel);
 
-    methodSymbols.dumpTable(subroutineName + " method");
-}
+        compileStatements(ast.child(ifNode, 1));
 
-// ( ( type varName ) ( ',' type varName )* )?
-void CompilationEngine::compileParameterList() {
-    if (nextTokenIs(Symbol::PAREN_R)) { return; }
-    while (true) {
-        std::string symbolType { reqToString( verifyVarType() ) };
-        compileVarName(symbolType, Segment::ARG, methodSymbols);
-        if (!nextTokenIs(Symbol::COMMA)) { break; }
-        process(Symbol::COMMA);
+        writer->writeLabel(gotoLabel);
+        return;
     }
-}
 
-// '{' varDec* statements '}'
-void CompilationEngine::compileSubroutineBody(const std::string& name, const Keyword& type) {
-    process(Symbol::CURLBRACE_L);
-    while (isVarDec()) { compileVarDec(); }
-    compileFunctionHeader(name, type);
-    compileStatements();
-    process(Symbol::CURLBRACE_R);
-}
+    compileFalseBranch(condition, ifLabel);
 
-// 'var' type varName ( ',' varName )* ';'
-void CompilationEngine::compileVarDec() {
-    process(Keyword::VAR);
-    std::string symbolType { reqToString( verifyVarType() ) };
-    while (true) {
-        compileVarName(symbolType, Segment::LOCAL, methodSymbols);
-        if (!nextTokenIs(Symbol::COMMA)) { break; }
-        process(Symbol::COMMA);
-    }
-    process(Symbol::SEMICOLON);
-}
+    compileStatements(ast.child(ifNode, 1));
 
-/*
-constructor: push # field vars, alloc, then pop address to THIS ptr
-method: pop this address (first arg) to THIS ptr
-function: no extra setup
-*/
-void CompilationEngine::compileFunctionHeader(const std::string& name, const Keyword& type) {
-    std::string functionName { currClassName + '.' + name };
-    int nVars { methodSymbols.varCount(Segment::LOCAL) };
-    writer.writeFunction(functionName, nVars);
-
-    if (type == Keyword::CONSTRUCTOR) {
-        int nFields { classSymbols.varCount(Segment::THIS) };
-        writer.writeConstant(nFields);
-        writer.writeCall(MEMORY_ALLOC, 1);
-        writer.writePopThisPtr();
-    } else if (type == Keyword::METHOD) {
-        const SymbolTable::Entry* entryPtr { methodSymbols.getEntry(+Keyword::THIS) };
-        Segment thisSegment { entryPtr->segment };
-        int thisIndex { entryPtr->index };
+    writer->writeGoto(gotoLabel);
+    writer->writeLabel(ifLabel);
 
-        writer.writePush(thisSegment, thisIndex);
-        writer.writePopThisPtr();
+    if (elseBlock != NO_NODE) {
+        compileStatements(elseBlock);
     }
-}
 
-std::string CompilationEngine::compileVarName(const std::string& type, const Segment& segment, SymbolTable& symbolTable) {
-    std::string name { processIdentifier() };
-    symbolTable.define(name, type, segment);
-    return name;
+    writer->writeLabel(gotoLabel);
 }
 
-const SymbolTable::Entry* CompilationEngine::compileVarName() {
-    std::string name { processIdentifier() };
-    if (const SymbolTable* symbolTable = getVarScope(name)) {
-        return symbolTable->getEntry(name);
-    }
-
-    throw SymbolError(name);
-}
+void CompilationEngine::compileWhile(NodeId whileNode) {
+    auto [loopLabel, exitLabel] { getLabelPair() };
 
-std::string CompilationEngine::compileName() {
-    return processIdentifier();
-}
+    NodeId condition { ast.child(whileNode, 0) };
 
-// ( className | varName ) '.' subroutineName '(' expressionList ')'
-//                           | subroutineName '(' expressionList ')'
-void CompilationEngine::compileSubroutineCall() {
     /*
-    internal method (no dot):   className is current class; push this to stack as first arg
-    external method (varName):  className is type(varName); push var to stack as first arg
-    external func (className):  className is provided; no extra setup
+    -O: a loop with a boolean condition is rotated so that the test sits at the bottom and jumps back to the body
+    while it holds: each iteration runs the test and one if-goto, instead of the test, not, if-goto and goto.
     */
+    if (optimize && isBoolean(condition)) {
+        writer->writeGoto(exitLabel);
+        writer->writeLabel(loopLabel);
 
-    std::string className { currClassName };
-    int nArgs { 1 };
-
-    if (compareToken(tokenizer.peekSecond(), Symbol::DOT)) {
-        std::string symbolName { std::get<std::string>( tokenizer.nextToken().val ) };
+        compileStatements(ast.child(whileNode, 1));
 
-        if (getVarScope(symbolName)) {
-            const SymbolTable::Entry* entryPtr { compileVarName() };
-            writer.writePush(entryPtr->segment, entryPtr->index);
-            className = entryPtr->type;
-        } else {
-            className = compileName();
-            nArgs = 0;
-        }
+        writer->writeLabel(exitLabel);
+        compileExpression(condition);
+        writer->writeIf(loopLabel);
+        return;
+    }
 
-        process(Symbol::DOT);
+    writer->writeLabel(loopLabel);
 
-    } else {
-        writer.writePushThisPtr();
-    }
+    compileFalseBranch(condition, exitLabel);
 
-    std::string subroutineName { compileName() };
-    process(Symbol::PAREN_L);
-    nArgs += compileExpressionList();
-    process(Symbol::PAREN_R);
+    compileStatements(ast.child(whileNode, 1));
 
-    std::string functionName { className + '.' + subroutineName };
-    writer.writeCall(functionName, nArgs);
+    writer->writeGoto(loopLabel);
+    writer->writeLabel(exitLabel);
 }
 
-// ( letStatement | ifStatement | whileStatement | doStatement | returnStatement )*
-void CompilationEngine::compileStatements() {
-    while (isStatement()) {
-        switch (std::get<Keyword>( tokenizer.nextToken().val )) {
-            case Keyword::LET:    compileLet();    break;
-            case Keyword::IF:     compileIf();     break;
-            case Keyword::WHILE:  compileWhile();  break;
-            case Keyword::DO:     compileDo();     break;
-            case Keyword::RETURN: compileReturn(); break;
-        }
+/*
+Jumps to the label unless the condition is true. With -O, a condition ~x jumps on x itself: not; not is the
+identity, whatever the value of x.
+*/
+void CompilationEngine::compileFalseBranch(NodeId condition, const int label) {
+    if (optimize && ast[condition].kind == NodeKind::UNARY && ast[condition].symbol() == Symbol::SQUIGGLE) {
+        compileExpression(ast.child(condition, 0));
+    } else {
+        compileExpression(condition);
+        writer->writeArithmetic(Command::NOT);
     }
+    writer->writeIf(label);
 }
 
-// 'let' varName ( '[' expression ']' )? '=' expression ';'
-void CompilationEngine::compileLet() {
-    process(Keyword::LET);
-    const SymbolTable::Entry* entryPtr { compileVarName() };
-
-    if (nextTokenIs(Symbol::SQRBRACK_L)) {
-        writer.writePush(entryPtr->segment, entryPtr->index);
-
-        process(Symbol::SQRBRACK_L);
-        compileExpression();
-        process(Symbol::SQRBRACK_R);
+/*
+True when the expression can only be true (-1) or false (0). The plain lowering treats every value but -1 as false,
+while if-goto jumps on any nonzero value, so only these conditions can be branched on directly.
+*/
+bool CompilationEngine::isBoolean(NodeId expression) const {
+    const Node& node { ast[expression] };
+    switch (node.kind) {
+        case NodeKind::KEYWORD_CONST:
+            return node.keyword() != Keyword::THIS;
+        case NodeKind::UNARY:
+            return node.symbol() == Symbol::SQUIGGLE && isBoolean(ast.child(expression, 0));
+        case NodeKind::BINARY:
+            switch (node.symbol()) {
+                case Symbol::LESS_THAN:
+                case Symbol::GREATER_THAN:
+                case Symbol::EQUAL:
+                    return true;
+                case Symbol::AMPERSAND:
+                case Symbol::VERTICAL_BAR:
+                    return isBoolean(ast.child(expression, 0)) && isBoolean(ast.child(expression, 1));
+                default:
+                    return false;
+            }
+        default:
+            return false;
+    }
+}
 
-        writer.writeArithmetic(Command::ADD);
+void CompilationEngine::compileDo(NodeId doNode) {
+    compileSubroutineCall(ast.child(doNode, 0));
+    writer->writePop(Segment::TEMP, 0);
+}
 
-        process(Symbol::EQUAL);
-        compileExpression();
-        process(Symbol::SEMICOLON);
+void CompilationEngine::compileReturn(NodeId returnNode) {
+    NodeId value { ast.child(returnNode, 0) };
 
-        writer.writePop(Segment::TEMP, 0);
-        writer.writePopThatPtr();
-        writer.writePush(Segment::TEMP, 0);
-        writer.writePop(Segment::THAT, 0);
+    if (value == NO_NODE) {
+        writer->writeConstant(0); // push dummy value; will be thrown away by caller
     } else {
-        process(Symbol::EQUAL);
-        compileExpression();
-        process(Symbol::SEMICOLON);
-
-        writer.writePop(entryPtr->segment, entryPtr->index);
+        compileExpression(value);
     }
+
+    writer->writeReturn();
 }
 
-// 'if' '(' expression ')' '{' statements '}' ( 'else' '{' statements '}' )?
-void CompilationEngine::compileIf() {
-    auto [ifLabel, gotoLabel] { getLabelPair() };
+// -O: the first evaluation of an expression that is repeated later in the statement keeps a copy of its value
+void CompilationEngine::compileExpression(NodeId expression) {
+    compileValue(expression);
 
-    process(Keyword::IF);
-    process(Symbol::PAREN_L);
-    compileExpression();
-    process(Symbol::PAREN_R);
+    if (optimize) {
+        auto cached { cachedValues.find(expression) };
+        if (cached != cachedValues.end()) {
+            writer->writePop(Segment::LOCAL, cached->second);
+            writer->writePush(Segment::LOCAL, cached->second);
+        }
+    }
+}
 
-    writer.writeArithmetic(Command::NOT);
-    writer.writeIf(ifLabel);
+// operands are evaluated left to right, then combined by the operator
+void CompilationEngine::compileValue(NodeId expression) {
+    if (ast[expression].kind != NodeKind::BINARY) {
+        compileTerm(expression);
+        return;
+    }
 
-    process(Symbol::CURLBRACE_L);
-    compileStatements();
-    process(Symbol::CURLBRACE_R);
+    Symbol op { ast[expression].symbol() };
+    if (optimize && op == Symbol::STAR && compileConstantMultiply(expression)) {
+        ++stats.mathCallsRemoved;
+        return;
+    }
 
-    writer.writeGoto(gotoLabel);
-    writer.writeLabel(ifLabel);
+    compileExpression(ast.child(expression, 0));
+    compileExpression(ast.child(expression, 1));
 
-    if (nextTokenIs(Keyword::ELSE)) {
-        process(Keyword::ELSE);
-        process(Symbol::CURLBRACE_L);
-        compileStatements();
-        process(Symbol::CURLBRACE_R);
+    if (commandLookup.find(op) != commandLookup.end()) {
+        writer->writeArithmetic(commandLookup.at(op));
+    } else {
+        writer->writeCall(mathLookup.at(op), 2);
     }
-
-    writer.writeLabel(gotoLabel);
 }
 
-// 'while' '(' expression ')' '{' statements '}'
-void CompilationEngine::compileWhile() {
-    auto [loopLabel, exitLabel] { getLabelPair() };
-
-    process(Keyword::WHILE);
-
-    writer.writeLabel(loopLabel);
-
-    process(Symbol::PAREN_L);
-    compileExpression();
-    process(Symbol::PAREN_R);
+/*
+x * c for a constant c: the product is built MSB first by doubling (pop to temp, push twice, add) and adding x
+for every set bit, then negated for negative c. x is kept in a temp only if it is needed again and is not a plain
+variable, which can simply be pushed again. Returns false, emitting nothing, when the chain would be longer than MAX_MULTIPLY_CHAIN.
+*/
+bool CompilationEngine::compileConstantMultiply(NodeId expression) {
+    NodeId operand { ast.child(expression, 0) };
+    NodeId constant { ast.child(expression, 1) };
+    if (ast[constant].kind != NodeKind::INT_CONST) {
+        std::swap(operand, constant);
+        if (ast[constant].kind != NodeKind::INT_CONST) { return false; }
+    }
 
-    writer.writeArithmetic(Command::NOT);
-    writer.writeIf(exitLabel);
+    int factor { static_cast<std::int16_t>(ast[constant].value) };
+    if (factor == 0 || factor == INT16_MIN) { return false; }
+    int magnitude { factor < 0 ? -factor : factor };
 
-    process(Symbol::CURLBRACE_L);
-    compileStatements();
-    process(Symbol::CURLBRACE_R);
+    int highBit { 0 };
+    int setBits { 0 };
+    for (int bit = 0; bit < 15; ++bit) {
+        if (magnitude >> bit & 1) {
+            highBit = bit;
+            ++setBits;
+        }
+    }
 
-    writer.writeGoto(loopLabel);
-    writer.writeLabel(exitLabel);
-}
+    bool isVar { ast[operand].kind == NodeKind::VAR };
+    bool spillOperand { setBits > 1 && !isVar };
+    bool hasCopy { isVar || spillOperand };
+    int cost { 4 * highBit + 2 * (setBits - 1) + (spillOperand ? 2 : 0) + (factor < 0 ? 1 : 0) - (hasCopy && highBit > 0 ? 2 : 0) };
+    if (cost > MAX_MULTIPLY_CHAIN) { return false; }
 
-// 'do' subroutineCall ';'
-void CompilationEngine::compileDo() {
-    process(Keyword::DO);
-    compileSubroutineCall();
-    process(Symbol::SEMICOLON);
+    auto pushOperand { [&] {
+        if (isVar) {
+            compileVarTerm(operand);
+        } else {
+            writer->writePush(Segment::TEMP, MULTIPLY_OPERAND_TEMP);
+        }
+    } };
 
-    writer.writePop(Segment::TEMP, 0);
-}
+    compileExpression(operand);
+    if (spillOperand) {
+        writer->writePop(Segment::TEMP, MULTIPLY_OPERAND_TEMP);
+        writer->writePush(Segment::TEMP, MULTIPLY_OPERAND_TEMP);
+    }
 
-// 'return' expression? ';'
-void CompilationEngine::compileReturn() {
-    process(Keyword::RETURN);
+    for (int bit = highBit - 1; bit >= 0; --bit) {
+        // the first doubling adds x to itself, so it can reuse the copy of x
+        if (bit == highBit - 1 && hasCopy) {
+            pushOperand();
+        } else {
+            writer->writePop(Segment::TEMP, MULTIPLY_PRODUCT_TEMP);
+            writer->writePush(Segment::TEMP, MULTIPLY_PRODUCT_TEMP);
+            writer->writePush(Segment::TEMP, MULTIPLY_PRODUCT_TEMP);
+        }
+        writer->writeArithmetic(Command::ADD);
 
-    if (nextTokenIs(Symbol::SEMICOLON)) {
-        writer.writeConstant(0); // push dummy value; will be thrown away by caller
-    } else {
-        compileExpression();
+        if (magnitude >> bit & 1) {
+            pushOperand();
+            writer->writeArithmetic(Command::ADD);
+        }
     }
 
-    process(Symbol::SEMICOLON);
-    writer.writeReturn();
+    if (factor < 0) {
+        writer->writeArithmetic(Command::NEG);
+    }
+    return true;
 }
 
-// term ( op term )*
-void CompilationEngine::compileExpression() {
-    compileTerm();
-
-    while (nextTokenIsOneOf(TokenSet::OPERATORS)) {
-        Symbol op { processSymbol() };
-        compileTerm();
-
-        if (commandLookup.find(op) != commandLookup.end()) {
-            writer.writeArithmetic(commandLookup.at(op));
-        } else {
-            writer.writeCall(mathLookup.at(op), 2);
-        }
+void CompilationEngine::compileTerm(NodeId term) {
+    switch (ast[term].kind) {
+        case NodeKind::INT_CONST:
+            compileIntConstTerm(term);
+            break;
+        case NodeKind::STRING_CONST:
+            compileStrConstTerm(term);
+            break;
+        case NodeKind::KEYWORD_CONST:
+            compileKeywordConstTerm(term);
+            break;
+        case NodeKind::VAR:
+            compileVarTerm(term);
+            break;
+        case NodeKind::ARRAY_ELEM:
+            compileArrayTerm(term);
+            break;
+        case NodeKind::CALL:
+            compileSubroutineCall(term);
+            break;
+        case NodeKind::UNARY:
+            compileExpression(ast.child(term, 0));
+            writer->writeArithmetic(ast[term].symbol() == Symbol::MINUS ? Command::NEG : Command::NOT);
+            break;
+        default:
+            compileValue(term);
+            break;
     }
 }
 
-// intConst | stringConst | keywordConst | varName | varName '[' expression ']'
-// | subroutineCall | '(' expression ')' | unaryOp term
-void CompilationEngine::compileTerm() {
-    // refactor this to use pointer returned by nextTokenIsOneOf
-    if (nextTokenIs(TokenType::INT_CONST)) {
-        writer.writeConstant( processIntConst() );
-    } else if (nextTokenIs(TokenType::STRING_CONST)) {
-        compileStrConstTerm();
-    } else if (nextTokenIsOneOf(TokenSet::KEYWORD_CONSTANTS)) {
-        compileKeywordConstTerm();
-    } else if (nextTokenIs(TokenType::IDENTIFIER)) {
-        compileIdentifierTerm();
-    } else if (nextTokenIs(Symbol::PAREN_L)) {
-        process(Symbol::PAREN_L);
-        compileExpression();
-        process(Symbol::PAREN_R);
-    } else if (nextTokenIsOneOf(TokenSet::UNARY_OPS)) {
-        Command op { processSymbol() == Symbol::MINUS ? Command::NEG : Command::NOT };
-        compileTerm();
-        writer.writeArithmetic(op);
+// folded constants hold a 16-bit pattern; VM constants only cover 0-32767
+void CompilationEngine::compileIntConstTerm(NodeId term) {
+    int value { static_cast<std::int16_t>(ast[term].value) };
+
+    if (value >= 0) {
+        writer->writeConstant(value);
+    } else if (value == INT16_MIN) {
+        writer->writeConstant(INT16_MAX);
+        writer->writeArithmetic(Command::NOT);
     } else {
-        std::string reqName { "term" };
-        handleInvalidToken(tokenizer.nextToken(), TokenType::IDENTIFIER, &reqName);
+        writer->writeConstant(-value);
+        writer->writeArithmetic(Command::NEG);
     }
 }
 
-// ( expression ( ',' expression )* )?
-int CompilationEngine::compileExpressionList() {
-    int count { 0 };
+void CompilationEngine::compileStrConstTerm(NodeId term) {
+    std::string_view str { ast.string(ast[term].value) };
 
-    if (!nextTokenIs(Symbol::PAREN_R)) {
-        while (true) {
-            compileExpression();
-            ++count;
-            if (!nextTokenIs(Symbol::COMMA)) { break; }
-            process(Symbol::COMMA);
-        }
+    if (poolStrings) {
+        writer->writePush(Segment::STATIC, stringSlots.at(str));
+    } else {
+        compileNewString(str);
     }
-
-    return count;
 }
 
-void CompilationEngine::compileStrConstTerm() {
-    std::string str { processStringConst() };
-
-    writer.writeConstant(str.length());
-    writer.writeCall(STRING_NEW, 1);
+void CompilationEngine::compileNewString(std::string_view str) {
+    writer->writeConstant(str.length());
+    writer->writeCall(BuiltinName::STRING_NEW, 1);
     for (const char& chr : str) {
-        writer.writeConstant(static_cast<int>(chr));
-        writer.writeCall(STRING_APPENDCHAR, 2);
+        writer->writeConstant(static_cast<int>(chr));
+        writer->writeCall(BuiltinName::STRING_APPENDCHAR, 2);
     }
 }
 
-// 'true' | 'false' | 'null' | 'this'
-void CompilationEngine::compileKeywordConstTerm() {
-    switch (processKeyword()) {
+void CompilationEngine::compileKeywordConstTerm(NodeId term) {
+    switch (ast[term].keyword()) {
         case Keyword::TRUE:
-            writer.writeConstant(1);
-            writer.writeArithmetic(Command::NEG);
+            writer->writeConstant(1);
+            writer->writeArithmetic(Command::NEG);
             break;
         case Keyword::THIS:
-            writer.writePushThisPtr();
+            writer->writePushThisPtr();
             break;
         default:
-            writer.writeConstant(0);
+            writer->writeConstant(0);
             break;
     }
 }
 
-// varName | varName '[' expression ']' | subroutineCall
-void CompilationEngine::compileIdentifierTerm() {
-    if (termIsSubroutineCall()) {
-        compileSubroutineCall();
-    } else {
-        const SymbolTable::Entry* entryPtr { compileVarName() };
-        writer.writePush(entryPtr->segment, entryPtr->index);
+void CompilationEngine::compileVarTerm(NodeId term) {
+    writer->writePush(ast[term].segment(), ast[term].value);
+}
 
-        if (termIsArrayExp()) {
-            process(Symbol::SQRBRACK_L);
-            compileExpression();
-            process(Symbol::SQRBRACK_R);
+void CompilationEngine::compileArrayTerm(NodeId term) {
+    int offset { compileArrayAddress(term) };
 
-            writer.writeArithmetic(Command::ADD);
-            writer.writePopThatPtr();
-            writer.writePush(Segment::THAT, 0);
-        }
+    writer->writePopThatPtr();
+    writer->writePush(Segment::THAT, offset);
+}
+
+/*
+Pushes the address of an array element and returns the offset from it into that. With -O, a constant index
+that is not negative becomes the offset itself, so only the base is pushed; otherwise base and index are added
+and the offset is 0.
+*/
+int CompilationEngine::compileArrayAddress(NodeId element) {
+    compileVarTerm(ast.child(element, 0));
+
+    NodeId index { ast.child(element, 1) };
+    if (optimize && ast[index].kind == NodeKind::INT_CONST && static_cast<std::int16_t>(ast[index].value) >= 0) {
+        return static_cast<int>(ast[index].value);
+    }
+
+    compileExpression(index);
+    writer->writeArithmetic(Command::ADD);
+    return 0;
+}
+
+/*
+True when evaluating the expression cannot change pointer 1: it reads no array element and makes no calls. Calls
+are excluded even though the callee's frame restores that, since --inline may later put the callee's body, which
+addresses fields through that, in place of the call.
+*/
+bool CompilationEngine::preservesThatPointer(NodeId expression) const {
+    switch (ast[expression].kind) {
+        case NodeKind::ARRAY_ELEM:
+        case NodeKind::CALL:
+            return false;
+        case NodeKind::STRING_CONST:
+            return poolStrings;
+        case NodeKind::BINARY:
+            if (mathLookup.count(ast[expression].symbol()) > 0) { return false; }
+            break;
+        default:
+            break;
+    }
+
+    for (NodeId child = ast[expression].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        if (!preservesThatPointer(child)) { return false; }
     }
+    return true;
 }
 
 }
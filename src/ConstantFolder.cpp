@@ -0,0 +1,171 @@
+#include "ConstantFolder.hpp"
+#include "CompilerResources.hpp"
+
+namespace Compiler {
+
+static constexpr std::int16_t TRUE_VALUE { -1 };
+
+static std::int16_t wrap(int value) {
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(value));
+}
+
+static std::int16_t fromBool(bool value) {
+    return value ? TRUE_VALUE : 0;
+}
+
+ConstantFolder::ConstantFolder(AST& tree) : ast(tree) {}
+
+void ConstantFolder::run() {
+    for (const SubroutineDec& subroutine : ast.subroutines) {
+        visit(subroutine.body);
+    }
+}
+
+// children are simplified first, so every operand is already as small as it can get
+void ConstantFolder::visit(NodeId node) {
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        visit(child);
+    }
+    simplify(node);
+}
+
+void ConstantFolder::simplify(NodeId node) {
+    if (ast[node].kind == NodeKind::UNARY) {
+        simplifyUnary(node);
+    } else if (ast[node].kind == NodeKind::BINARY) {
+        simplifyBinary(node);
+    }
+}
+
+void ConstantFolder::simplifyUnary(NodeId node) {
+    NodeId operand { ast[node].firstChild };
+    Symbol op { ast[node].symbol() };
+
+    if (std::optional<std::int16_t> value { constantValue(operand) }) {
+        replaceWithConstant(node, op == Symbol::MINUS ? wrap(-*value) : wrap(~*value));
+    } else if (ast[operand].kind == NodeKind::UNARY && ast[operand].op == ast[node].op) {
+        // -(-x) and ~(~x)
+        replaceWithNode(node, ast[operand].firstChild);
+    }
+}
+
+void ConstantFolder::simplifyBinary(NodeId node) {
+    NodeId left { ast.child(node, 0) };
+    NodeId right { ast.child(node, 1) };
+    std::optional<std::int16_t> x { constantValue(left) };
+    std::optional<std::int16_t> y { constantValue(right) };
+    Symbol op { ast[node].symbol() };
+
+    if (x && y) {
+        switch (op) {
+            case Symbol::PLUS:         replaceWithConstant(node, wrap(*x + *y)); break;
+            case Symbol::MINUS:        replaceWithConstant(node, wrap(*x - *y)); break;
+            case Symbol::STAR:         replaceWithConstant(node, wrap(*x * *y)); break;
+            case Symbol::AMPERSAND:    replaceWithConstant(node, wrap(*x & *y)); break;
+            case Symbol::VERTICAL_BAR: replaceWithConstant(node, wrap(*x | *y)); break;
+            case Symbol::LESS_THAN:    replaceWithConstant(node, fromBool(*x < *y)); break;
+            case Symbol::GREATER_THAN: replaceWithConstant(node, fromBool(*x > *y)); break;
+            case Symbol::EQUAL:        replaceWithConstant(node, fromBool(*x == *y)); break;
+            case Symbol::SLASH:
+                // division by zero is reported by Math.divide at run time, and the OS does not define -32768 / -1
+                if (*y != 0 && !(*x == INT16_MIN && *y == -1)) {
+                    replaceWithConstant(node, wrap(*x / *y));
+                }
+                break;
+            default: break;
+        }
+        return;
+    }
+
+    switch (op) {
+        case Symbol::PLUS:
+            if (y == 0) { replaceWithNode(node, left); }
+            else if (x == 0) { replaceWithNode(node, right); }
+            break;
+        case Symbol::MINUS:
+            if (y == 0) { replaceWithNode(node, left); }
+            else if (x == 0) { replaceWithNegation(node, right); }
+            break;
+        case Symbol::STAR:
+            if (y == 1) { replaceWithNode(node, left); }
+            else if (x == 1) { replaceWithNode(node, right); }
+            else if (y == -1) { replaceWithNegation(node, left); }
+            else if (x == -1) { replaceWithNegation(node, right); }
+            else if ((y == 0 && isPure(left)) || (x == 0 && isPure(right))) { replaceWithConstant(node, 0); }
+            break;
+        case Symbol::SLASH:
+            if (y == 1) { replaceWithNode(node, left); }
+            else if (y == -1) { replaceWithNegation(node, left); }
+            break;
+        case Symbol::AMPERSAND:
+            if (y == TRUE_VALUE) { replaceWithNode(node, left); }
+            else if (x == TRUE_VALUE) { replaceWithNode(node, right); }
+            else if ((y == 0 && isPure(left)) || (x == 0 && isPure(right))) { replaceWithConstant(node, 0); }
+            break;
+        case Symbol::VERTICAL_BAR:
+            if (y == 0) { replaceWithNode(node, left); }
+            else if (x == 0) { replaceWithNode(node, right); }
+            else if ((y == TRUE_VALUE && isPure(left)) || (x == TRUE_VALUE && isPure(right))) { replaceWithConstant(node, TRUE_VALUE); }
+            break;
+        default:
+            break;
+    }
+}
+
+std::optional<std::int16_t> ConstantFolder::constantValue(NodeId node) const {
+    const Node& n { ast[node] };
+    if (n.kind == NodeKind::INT_CONST) {
+        return wrap(static_cast<int>(n.value));
+    }
+    if (n.kind == NodeKind::KEYWORD_CONST && n.keyword() != Keyword::THIS) {
+        return n.keyword() == Keyword::TRUE ? TRUE_VALUE : 0;
+    }
+    return std::nullopt;
+}
+
+bool ConstantFolder::isPure(NodeId node) const {
+    switch (ast[node].kind) {
+        case NodeKind::CALL:
+        case NodeKind::STRING_CONST:
+            return false;
+        case NodeKind::BINARY:
+            if (ast[node].symbol() == Symbol::SLASH) { return false; }
+            break;
+        default:
+            break;
+    }
+
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        if (!isPure(child)) { return false; }
+    }
+    return true;
+}
+
+// nodes are rewritten in place so that the parent's links, and this node's next sibling, stay valid
+
+void ConstantFolder::replaceWithConstant(NodeId node, std::int16_t value) {
+    Node& n { ast[node] };
+    n.kind = NodeKind::INT_CONST;
+    n.op = 0;
+    n.value = static_cast<std::uint16_t>(value);
+    n.firstChild = NO_NODE;
+}
+
+void ConstantFolder::replaceWithNode(NodeId node, NodeId replacement) {
+    NodeId nextSibling { ast[node].nextSibling };
+    ast[node] = ast[replacement];
+    ast[node].nextSibling = nextSibling;
+}
+
+void ConstantFolder::replaceWithNegation(NodeId node, NodeId operand) {
+    Node& n { ast[node] };
+    n.kind = NodeKind::UNARY;
+    n.op = static_cast<std::uint8_t>(Symbol::MINUS);
+    n.value = 0;
+    n.firstChild = operand;
+    ast[operand].nextSibling = NO_NODE;
+
+    simplifyUnary(node);
+}
+
+}
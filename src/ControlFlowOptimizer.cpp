@@ -0,0 +1,292 @@
+#include "ControlFlowOptimizer.hpp"
+
+#include <unordered_set>
+#include <utility>
+
+namespace Compiler {
+
+ControlFlowOptimizer::ControlFlowOptimizer(std::unique_ptr<VMWriter> output) :
+    writer(std::move(output)) {}
+
+ControlFlowOptimizer::~ControlFlowOptimizer() {
+    flush();
+}
+
+void ControlFlowOptimizer::writePush(const Segment& segment, const int index) {
+    code.push_back({VMOp::PUSH, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void ControlFlowOptimizer::writePop(const Segment& segment, const int index) {
+    code.push_back({VMOp::POP, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void ControlFlowOptimizer::writeArithmetic(const Command& command) {
+    code.push_back({VMOp::ARITHMETIC, static_cast<std::uint8_t>(command), 0, 0});
+}
+
+void ControlFlowOptimizer::writeLabel(const int label) {
+    code.push_back({VMOp::LABEL, 0, label, 0});
+}
+
+void ControlFlowOptimizer::writeGoto(const int label) {
+    code.push_back({VMOp::GOTO, 0, label, 0});
+}
+
+void ControlFlowOptimizer::writeIf(const int label) {
+    code.push_back({VMOp::IF, 0, label, 0});
+}
+
+void ControlFlowOptimizer::writeCall(Name name, const int nArgs) {
+    code.push_back({VMOp::CALL, 0, nArgs, name});
+}
+
+void ControlFlowOptimizer::writeFunction(Name name, const int nVars) {
+    flush();
+    writer->writeFunction(name, nVars);
+}
+
+void ControlFlowOptimizer::writeReturn() {
+    code.push_back({VMOp::RETURN, 0, 0, 0});
+}
+
+void ControlFlowOptimizer::finish() {
+    flush();
+    writer->finish();
+}
+
+void ControlFlowOptimizer::flush() {
+    if (code.empty()) { return; }
+
+    buildBlocks();
+    threadJumps();
+    removeUnreachableBlocks();
+    layoutBlocks();
+    removeRedundantJumps();
+    writeBlocks();
+
+    code.clear();
+    blocks.clear();
+}
+
+const FlowStats& ControlFlowOptimizer::getStats() const {
+    return stats;
+}
+
+// a block starts at the first of a run of labels or after a jump or return; block 0 is the function's entry
+void ControlFlowOptimizer::buildBlocks() {
+    blocks.emplace_back();
+
+    for (const VMInstruction& instruction : code) {
+        if (instruction.op == VMOp::LABEL) {
+            if (!blocks.back().code.empty()) {
+                blocks.emplace_back();
+            }
+            blocks.back().labels.push_back(instruction.arg);
+            continue;
+        }
+
+        blocks.back().code.push_back(instruction);
+        if (exitJump(blocks.back()) != nullptr) {
+            blocks.emplace_back();
+        }
+    }
+
+    if (blocks.size() > 1 && blocks.back().labels.empty() && blocks.back().code.empty()) {
+        blocks.pop_back();
+    }
+
+    mapLabels();
+}
+
+void ControlFlowOptimizer::mapLabels() {
+    labelBlocks.clear();
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        for (int label : blocks[b].labels) {
+            labelBlocks[label] = b;
+        }
+    }
+}
+
+// a jump to a block holding nothing but a goto continues to that goto's target
+void ControlFlowOptimizer::threadJumps() {
+    for (BasicBlock& block : blocks) {
+        if (block.code.empty()) { continue; }
+
+        VMInstruction& jump { block.code.back() };
+        if (jump.op != VMOp::GOTO && jump.op != VMOp::IF) { continue; }
+
+        int label { jump.arg };
+        for (std::size_t hops = 0; hops < blocks.size(); ++hops) {
+            const BasicBlock& target { blocks[targetBlock(label)] };
+            if (target.code.size() != 1 || target.code[0].op != VMOp::GOTO || target.code[0].arg == label) { break; }
+            label = target.code[0].arg;
+        }
+
+        if (label != jump.arg) {
+            jump.arg = label;
+            ++stats.jumpsThreaded;
+        }
+    }
+}
+
+void ControlFlowOptimizer::removeUnreachableBlocks() {
+    std::vector<bool> reachable(blocks.size(), false);
+    std::vector<std::size_t> worklist { 0 };
+    reachable[0] = true;
+
+    auto visit = [&](std::size_t b) {
+        if (!reachable[b]) {
+            reachable[b] = true;
+            worklist.push_back(b);
+        }
+    };
+
+    while (!worklist.empty()) {
+        std::size_t b { worklist.back() };
+        worklist.pop_back();
+
+        const VMInstruction* jump { exitJump(blocks[b]) };
+        if (jump != nullptr && jump->op != VMOp::RETURN) {
+            visit(targetBlock(jump->arg));
+        }
+        if (fallsThrough(blocks[b]) && b + 1 < blocks.size()) {
+            visit(b + 1);
+        }
+    }
+
+    std::vector<BasicBlock> kept;
+    kept.reserve(blocks.size());
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        if (reachable[b]) {
+            kept.push_back(std::move(blocks[b]));
+        } else {
+            ++stats.unreachableBlocks;
+        }
+    }
+    blocks = std::move(kept);
+
+    mapLabels();
+}
+
+/*
+A block whose only predecessor is a goto, and which does not fall through itself, is moved to directly after that
+goto, and the goto is dropped. Nothing falls into the block at its old position, and nothing relies on what
+follows it, so no other edge changes.
+*/
+void ControlFlowOptimizer::layoutBlocks() {
+    std::vector<int> predecessors(blocks.size(), 0);
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        const VMInstruction* jump { exitJump(blocks[b]) };
+        if (jump != nullptr && jump->op != VMOp::RETURN) {
+            ++predecessors[targetBlock(jump->arg)];
+        }
+        if (fallsThrough(blocks[b]) && b + 1 < blocks.size()) {
+            ++predecessors[b + 1];
+        }
+    }
+
+    std::vector<BasicBlock> ordered;
+    ordered.reserve(blocks.size());
+    std::vector<bool> placed(blocks.size(), false);
+
+    for (std::size_t start = 0; start < blocks.size(); ++start) {
+        std::size_t b { start };
+        while (!placed[b]) {
+            placed[b] = true;
+            ordered.push_back(std::move(blocks[b]));
+
+            const VMInstruction* jump { exitJump(ordered.back()) };
+            if (jump == nullptr || jump->op != VMOp::GOTO) { break; }
+
+            std::size_t next { targetBlock(jump->arg) };
+            if (next == 0 || placed[next] || predecessors[next] != 1 || fallsThrough(blocks[next])) { break; }
+
+            ordered.back().code.pop_back();
+            ++stats.blocksMerged;
+            b = next;
+        }
+    }
+    blocks = std::move(ordered);
+
+    mapLabels();
+}
+
+// if-goto to the next block still has to discard its condition, so it becomes a pop into scratch temp 0
+void ControlFlowOptimizer::removeRedundantJumps() {
+    for (std::size_t b = 0; b + 1 < blocks.size(); ++b) {
+        const VMInstruction* jump { exitJump(blocks[b]) };
+        if (jump == nullptr || jump->op == VMOp::RETURN || targetBlock(jump->arg) != b + 1) { continue; }
+
+        if (jump->op == VMOp::GOTO) {
+            blocks[b].code.pop_back();
+        } else {
+            blocks[b].code.back() = {VMOp::POP, static_cast<std::uint8_t>(Segment::TEMP), 0, 0};
+        }
+        ++stats.jumpsRemoved;
+    }
+}
+
+// every referenced label of a block is renamed to the block's new number; unreferenced labels disappear
+void ControlFlowOptimizer::writeBlocks() {
+    std::unordered_set<int> referenced;
+    for (const BasicBlock& block : blocks) {
+        const VMInstruction* jump { exitJump(block) };
+        if (jump != nullptr && jump->op != VMOp::RETURN) {
+            referenced.insert(jump->arg);
+        }
+    }
+
+    std::unordered_map<int, int> renamed;
+    int labelCount { 0 };
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        bool named { false };
+        for (int label : blocks[b].labels) {
+            if (referenced.count(label) > 0) {
+                renamed[label] = labelCount;
+                named = true;
+            }
+        }
+
+        if (named) {
+            ++labelCount;
+        } else if (b > 0 && !blocks[b].labels.empty()) {
+            ++stats.blocksMerged;
+        }
+    }
+
+    for (const BasicBlock& block : blocks) {
+        for (int label : block.labels) {
+            auto it { renamed.find(label) };
+            if (it != renamed.end()) {
+                writer->writeLabel(it->second);
+                break;
+            }
+        }
+
+        for (VMInstruction instruction : block.code) {
+            if (instruction.op == VMOp::GOTO || instruction.op == VMOp::IF) {
+                instruction.arg = renamed.at(instruction.arg);
+            }
+            writer->write(instruction);
+        }
+    }
+}
+
+std::size_t ControlFlowOptimizer::targetBlock(int label) const {
+    return labelBlocks.at(label);
+}
+
+const VMInstruction* ControlFlowOptimizer::exitJump(const BasicBlock& block) const {
+    if (block.code.empty()) { return nullptr; }
+
+    const VMInstruction& last { block.code.back() };
+    bool isJump { last.op == VMOp::GOTO || last.op == VMOp::IF || last.op == VMOp::RETURN };
+    return isJump ? &last : nullptr;
+}
+
+bool ControlFlowOptimizer::fallsThrough(const BasicBlock& block) const {
+    const VMInstruction* jump { exitJump(block) };
+    return jump == nullptr || jump->op == VMOp::IF;
+}
+
+}
@@ -0,0 +1,130 @@
+#include "HackAssembler.hpp"
+#include "utils.hpp"
+
+#include <charconv>
+#include <vector>
+
+namespace Compiler {
+
+AssemblyError::AssemblyError(const std::string& reason) :
+    JackCompilerError("Invalid assembly: " + reason + '\n') {}
+
+struct CompEncoding {
+    std::string_view comp;
+    std::uint16_t bits;     // a-bit and c1-c6
+};
+
+static constexpr CompEncoding COMP_TABLE[] {
+    {"0", 0b0101010}, {"1", 0b0111111}, {"-1", 0b0111010}, {"D", 0b0001100}, {"A", 0b0110000}, {"M", 0b1110000},
+    {"!D", 0b0001101}, {"!A", 0b0110001}, {"!M", 0b1110001}, {"-D", 0b0001111}, {"-A", 0b0110011}, {"-M", 0b1110011},
+    {"D+1", 0b0011111}, {"A+1", 0b0110111}, {"M+1", 0b1110111}, {"D-1", 0b0001110}, {"A-1", 0b0110010}, {"M-1", 0b1110010},
+    {"D+A", 0b0000010}, {"D+M", 0b1000010}, {"A+D", 0b0000010}, {"M+D", 0b1000010},
+    {"D-A", 0b0010011}, {"D-M", 0b1010011}, {"A-D", 0b0000111}, {"M-D", 0b1000111},
+    {"D&A", 0b0000000}, {"D&M", 0b1000000}, {"A&D", 0b0000000}, {"M&D", 0b1000000},
+    {"D|A", 0b0010101}, {"D|M", 0b1010101}, {"A|D", 0b0010101}, {"M|D", 0b1010101}
+};
+
+static constexpr std::string_view JUMP_TABLE[] { "", "JGT", "JEQ", "JGE", "JLT", "JNE", "JLE", "JMP" };
+
+static std::string_view trim(std::string_view line) {
+    std::size_t comment { line.find("//") };
+    if (comment != std::string_view::npos) { line = line.substr(0, comment); }
+
+    std::size_t first { line.find_first_not_of(" \t\r") };
+    if (first == std::string_view::npos) { return {}; }
+    return line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+}
+
+HackAssembler::HackAssembler(std::string_view program) :
+    source(program),
+    symbols {
+        {"SP", 0}, {"LCL", 1}, {"ARG", 2}, {"THIS", 3}, {"THAT", 4},
+        {"R0", 0}, {"R1", 1}, {"R2", 2}, {"R3", 3}, {"R4", 4}, {"R5", 5}, {"R6", 6}, {"R7", 7},
+        {"R8", 8}, {"R9", 9}, {"R10", 10}, {"R11", 11}, {"R12", 12}, {"R13", 13}, {"R14", 14}, {"R15", 15},
+        {"SCREEN", 16384}, {"KBD", 24576}
+    },
+    nextVariable(FIRST_VARIABLE) {}
+
+std::uint16_t HackAssembler::encodeAddress(std::string_view value) {
+    if (isDigit(value.front())) {
+        unsigned address { 0 };
+        auto [end, error] { std::from_chars(value.data(), value.data() + value.size(), address) };
+        if (error != std::errc() || end != value.data() + value.size() || address > 32767) {
+            throw AssemblyError("bad address @" + std::string(value));
+        }
+        return static_cast<std::uint16_t>(address);
+    }
+
+    auto [it, inserted] { symbols.emplace(value, nextVariable) };
+    if (inserted) { ++nextVariable; }
+    return it->second;
+}
+
+std::uint16_t HackAssembler::encodeCompute(std::string_view instruction) {
+    std::uint16_t dest { 0 };
+    std::size_t equals { instruction.find('=') };
+    if (equals != std::string_view::npos) {
+        for (char chr : instruction.substr(0, equals)) {
+            if (chr == 'A') { dest |= 0b100; }
+            else if (chr == 'D') { dest |= 0b010; }
+            else if (chr == 'M') { dest |= 0b001; }
+            else { throw AssemblyError("bad destination in " + std::string(instruction)); }
+        }
+        instruction.remove_prefix(equals + 1);
+    }
+
+    std::uint16_t jump { 0 };
+    std::size_t semicolon { instruction.find(';') };
+    if (semicolon != std::string_view::npos) {
+        std::string_view mnemonic { instruction.substr(semicolon + 1) };
+        while (jump < std::size(JUMP_TABLE) && JUMP_TABLE[jump] != mnemonic) { ++jump; }
+        if (jump == std::size(JUMP_TABLE) || jump == 0) { throw AssemblyError("bad jump " + std::string(mnemonic)); }
+        instruction = instruction.substr(0, semicolon);
+    }
+
+    for (const CompEncoding& encoding : COMP_TABLE) {
+        if (encoding.comp == instruction) {
+            return static_cast<std::uint16_t>(0b111 << 13 | encoding.bits << 6 | dest << 3 | jump);
+        }
+    }
+    throw AssemblyError("bad computation " + std::string(instruction));
+}
+
+std::string HackAssembler::assemble() {
+    std::vector<std::string_view> instructions;
+    std::string_view remaining { source };
+
+    // first pass: collect instructions and bind each label to the address of the instruction that follows it
+    while (!remaining.empty()) {
+        std::size_t newline { remaining.find('\n') };
+        std::string_view line { trim(remaining.substr(0, newline)) };
+        remaining.remove_prefix(newline == std::string_view::npos ? remaining.size() : newline + 1);
+
+        if (line.empty()) { continue; }
+        if (line.front() == '(') {
+            if (line.back() != ')' || line.size() < 3) { throw AssemblyError("bad label " + std::string(line)); }
+            symbols[line.substr(1, line.size() - 2)] = static_cast<std::uint16_t>(instructions.size());
+        } else {
+            instructions.push_back(line);
+        }
+    }
+
+    if (instructions.size() > ROM_SIZE) {
+        throw AssemblyError("program needs " + std::to_string(instructions.size()) + " instructions; ROM holds " + std::to_string(ROM_SIZE));
+    }
+
+    std::string output;
+    output.reserve(instructions.size() * 17);
+    for (std::string_view instruction : instructions) {
+        if (instruction == "@") { throw AssemblyError("missing address"); }
+
+        std::uint16_t word { instruction.front() == '@' ? encodeAddress(instruction.substr(1)) : encodeCompute(instruction) };
+        for (int bit = 15; bit >= 0; --bit) {
+            output += (word >> bit & 1) ? '1' : '0';
+        }
+        output += '\n';
+    }
+    return output;
+}
+
+}
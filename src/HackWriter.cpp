@@ -0,0 +1,305 @@
+#include "HackWriter.hpp"
+#include "CompilerResources.hpp"
+
+#include <charconv>
+#include <unordered_set>
+
+namespace Compiler {
+
+LinkError::LinkError(const std::string& functions) :
+    JackCompilerError("Undefined functions: " + functions + '\n') {}
+
+/*
+Shared routines. Call sites jump here with the return address in D.
+$$CALL expects the callee address in R13 and the argument count in R14, and builds the standard frame.
+$$RETURN restores the caller's frame from LCL. $$EQ/$$GT/$$LT replace the top two stack values with the comparison.
+*/
+static constexpr std::string_view BOOTSTRAP {
+    "@256\nD=A\n@SP\nM=D\n"
+    "@R14\nM=0\n@Sys.init\nD=A\n@R13\nM=D\n@$$HALT\nD=A\n@$$CALL\n0;JMP\n"
+    "($$HALT)\n@$$HALT\n0;JMP\n"
+
+    "($$CALL)\n"
+    "@SP\nAM=M+1\nA=A-1\nM=D\n"
+    "@LCL\nD=M\n@SP\nAM=M+1\nA=A-1\nM=D\n"
+    "@ARG\nD=M\n@SP\nAM=M+1\nA=A-1\nM=D\n"
+    "@THIS\nD=M\n@SP\nAM=M+1\nA=A-1\nM=D\n"
+    "@THAT\nD=M\n@SP\nAM=M+1\nA=A-1\nM=D\n"
+    "@R14\nD=M\n@5\nD=D+A\n@SP\nD=M-D\n@ARG\nM=D\n"
+    "@SP\nD=M\n@LCL\nM=D\n"
+    "@R13\nA=M\n0;JMP\n"
+
+    "($$RETURN)\n"
+    "@5\nD=A\n@LCL\nA=M-D\nD=M\n@R14\nM=D\n"
+    "@SP\nAM=M-1\nD=M\n@ARG\nA=M\nM=D\n"
+    "@ARG\nD=M+1\n@SP\nM=D\n"
+    "@LCL\nAM=M-1\nD=M\n@THAT\nM=D\n"
+    "@LCL\nAM=M-1\nD=M\n@THIS\nM=D\n"
+    "@LCL\nAM=M-1\nD=M\n@ARG\nM=D\n"
+    "@LCL\nAM=M-1\nD=M\n@LCL\nM=D\n"
+    "@R14\nA=M\n0;JMP\n"
+
+    "($$EQ)\n@R15\nM=D\n@SP\nAM=M-1\nD=M\nA=A-1\nD=M-D\nM=-1\n@$$EQ_END\nD;JEQ\n@SP\nA=M-1\nM=0\n($$EQ_END)\n@R15\nA=M\n0;JMP\n"
+
+    // operands of different signs are ordered by sign alone, since x - y can overflow
+    "($$GT)\n@R15\nM=D\n@SP\nAM=M-1\nD=M\n@R13\nM=D\n@SP\nA=M-1\nD=M\n@$$GT_XNEG\nD;JLT\n"
+    "@R13\nD=M\n@$$GT_TRUE\nD;JLT\n@$$GT_SUB\n0;JMP\n"
+    "($$GT_XNEG)\n@R13\nD=M\n@$$GT_FALSE\nD;JGE\n"
+    "($$GT_SUB)\n@R13\nD=M\n@SP\nA=M-1\nD=M-D\n@$$GT_TRUE\nD;JGT\n"
+    "($$GT_FALSE)\n@SP\nA=M-1\nM=0\n@R15\nA=M\n0;JMP\n"
+    "($$GT_TRUE)\n@SP\nA=M-1\nM=-1\n@R15\nA=M\n0;JMP\n"
+
+    "($$LT)\n@R15\nM=D\n@SP\nAM=M-1\nD=M\n@R13\nM=D\n@SP\nA=M-1\nD=M\n@$$LT_XNEG\nD;JLT\n"
+    "@R13\nD=M\n@$$LT_FALSE\nD;JLT\n@$$LT_SUB\n0;JMP\n"
+    "($$LT_XNEG)\n@R13\nD=M\n@$$LT_TRUE\nD;JGE\n"
+    "($$LT_SUB)\n@R13\nD=M\n@SP\nA=M-1\nD=M-D\n@$$LT_TRUE\nD;JLT\n"
+    "($$LT_FALSE)\n@SP\nA=M-1\nM=0\n@R15\nA=M\n0;JMP\n"
+    "($$LT_TRUE)\n@SP\nA=M-1\nM=-1\n@R15\nA=M\n0;JMP\n"
+};
+
+static constexpr std::string_view SEGMENT_BASES[] { "THIS", "THIS", "", "ARG", "LCL", "", "THAT", "", "" };
+
+HackWriter::HackWriter(AsmModule& output, const InternPool& namePool, std::string_view fileName) :
+    module(output),
+    out(output.code),
+    pool(namePool),
+    fileName(fileName),
+    returnCount(0) {}
+
+void HackWriter::line(std::string_view text) {
+    out.append(text);
+    out += '\n';
+}
+
+void HackWriter::appendInt(int value) {
+    char digits[16];
+    auto [end, error] { std::to_chars(digits, digits + sizeof(digits), value) };
+    out.append(digits, end);
+}
+
+void HackWriter::loadAddress(int value) {
+    out += '@';
+    appendInt(value);
+    out += '\n';
+}
+
+// VM labels are scoped to their function
+void HackWriter::writeLabelName(int label) {
+    out.append(currentFunction);
+    out.append("$L");
+    appendInt(label);
+}
+
+void HackWriter::writeReturnLabel(int id) {
+    out.append(currentFunction);
+    out.append("$ret.");
+    appendInt(id);
+}
+
+// D holds the return address, then control continues at the label that follows
+void HackWriter::jumpToRoutine(std::string_view routine) {
+    int id { returnCount++ };
+    out += '@';
+    writeReturnLabel(id);
+    out += '\n';
+    line("D=A");
+    out += '@';
+    out.append(routine);
+    out += '\n';
+    line("0;JMP");
+    out += '(';
+    writeReturnLabel(id);
+    out += ")\n";
+}
+
+void HackWriter::pushD() {
+    line("@SP\nAM=M+1\nA=A-1\nM=D");
+}
+
+void HackWriter::popD() {
+    line("@SP\nAM=M-1\nD=M");
+}
+
+bool HackWriter::isDirect(Segment segment) const {
+    return segment == Segment::TEMP || segment == Segment::POINTER || segment == Segment::STATIC;
+}
+
+void HackWriter::loadDirectAddress(Segment segment, int index) {
+    if (segment == Segment::TEMP) {
+        loadAddress(TEMP_BASE + index);
+    } else if (segment == Segment::POINTER) {
+        line(index == 0 ? "@THIS" : "@THAT");
+    } else {
+        out += '@';
+        out.append(fileName);
+        out += '.';
+        appendInt(index);
+        out += '\n';
+    }
+}
+
+void HackWriter::loadSegmentBase(Segment segment) {
+    out += '@';
+    out.append(SEGMENT_BASES[static_cast<std::size_t>(segment)]);
+    out += '\n';
+}
+
+void HackWriter::writePush(const Segment& segment, const int index) {
+    if (segment == Segment::CONST) {
+        if (index == 0 || index == 1) {
+            line("@SP\nAM=M+1\nA=A-1");
+            line(index == 0 ? "M=0" : "M=1");
+            return;
+        }
+        loadAddress(index);
+        line("D=A");
+    } else if (isDirect(segment)) {
+        loadDirectAddress(segment, index);
+        line("D=M");
+    } else if (index <= SMALL_OFFSET) {
+        loadSegmentBase(segment);
+        line(index == 0 ? "A=M" : "A=M+1");
+        for (int i = 1; i < index; ++i) { line("A=A+1"); }
+        line("D=M");
+    } else {
+        loadAddress(index);
+        line("D=A");
+        loadSegmentBase(segment);
+        line("A=D+M\nD=M");
+    }
+    pushD();
+}
+
+void HackWriter::writePop(const Segment& segment, const int index) {
+    if (isDirect(segment)) {
+        popD();
+        loadDirectAddress(segment, index);
+        line("M=D");
+    } else if (index <= SMALL_OFFSET) {
+        popD();
+        loadSegmentBase(segment);
+        line(index == 0 ? "A=M" : "A=M+1");
+        for (int i = 1; i < index; ++i) { line("A=A+1"); }
+        line("M=D");
+    } else {
+        loadAddress(index);
+        line("D=A");
+        loadSegmentBase(segment);
+        line("D=D+M\n@R13\nM=D");
+        popD();
+        line("@R13\nA=M\nM=D");
+    }
+}
+
+void HackWriter::writeArithmetic(const Command& command) {
+    switch (command) {
+        case Command::ADD: line("@SP\nAM=M-1\nD=M\nA=A-1\nM=D+M"); break;
+        case Command::SUB: line("@SP\nAM=M-1\nD=M\nA=A-1\nM=M-D"); break;
+        case Command::AND: line("@SP\nAM=M-1\nD=M\nA=A-1\nM=D&M"); break;
+        case Command::OR:  line("@SP\nAM=M-1\nD=M\nA=A-1\nM=D|M"); break;
+        case Command::NEG: line("@SP\nA=M-1\nM=-M"); break;
+        case Command::NOT: line("@SP\nA=M-1\nM=!M"); break;
+        case Command::EQ:  jumpToRoutine("$$EQ"); break;
+        case Command::GT:  jumpToRoutine("$$GT"); break;
+        case Command::LT:  jumpToRoutine("$$LT"); break;
+    }
+}
+
+void HackWriter::writeLabel(const int label) {
+    out += '(';
+    writeLabelName(label);
+    out += ")\n";
+}
+
+void HackWriter::writeGoto(const int label) {
+    out += '@';
+    writeLabelName(label);
+    out += '\n';
+    line("0;JMP");
+}
+
+void HackWriter::writeIf(const int label) {
+    popD();
+    out += '@';
+    writeLabelName(label);
+    out += '\n';
+    line("D;JNE");
+}
+
+void HackWriter::writeCall(Name name, const int nArgs) {
+    module.calls.push_back(name);
+
+    if (nArgs == 0) {
+        line("@R14\nM=0");
+    } else {
+        loadAddress(nArgs);
+        line("D=A\n@R14\nM=D");
+    }
+    out += '@';
+    out.append(pool.str(name));
+    out += '\n';
+    line("D=A\n@R13\nM=D");
+    jumpToRoutine("$$CALL");
+}
+
+// locals are zeroed in place and SP is moved past them once
+void HackWriter::writeFunction(Name name, const int nVars) {
+    module.functions.push_back(name);
+    currentFunction = pool.str(name);
+    returnCount = 0;
+
+    out += '(';
+    out.append(currentFunction);
+    out += ")\n";
+
+    if (nVars > 0) {
+        line("@SP\nA=M\nM=0");
+        for (int i = 1; i < nVars; ++i) { line("A=A+1\nM=0"); }
+        line("D=A+1\n@SP\nM=D");
+    }
+}
+
+void HackWriter::writeReturn() {
+    line("@$$RETURN\n0;JMP");
+}
+
+std::string HackWriter::link(const std::vector<const AsmModule*>& modules, const InternPool& namePool) {
+    std::unordered_set<Name> defined;
+    std::size_t size { BOOTSTRAP.size() };
+    for (const AsmModule* module : modules) {
+        defined.insert(module->functions.begin(), module->functions.end());
+        size += module->code.size();
+    }
+
+    std::string undefined;
+    std::unordered_set<std::string_view> reported;
+    auto check { [&](std::string_view function, bool isDefined) {
+        if (isDefined || !reported.insert(function).second) { return; }
+        if (!undefined.empty()) { undefined += ", "; }
+        undefined.append(function);
+    } };
+
+    bool hasSysInit { false };
+    for (Name function : defined) {
+        hasSysInit = hasSysInit || namePool.str(function) == "Sys.init";
+    }
+    check("Sys.init", hasSysInit);
+    for (const AsmModule* module : modules) {
+        for (Name call : module->calls) {
+            check(namePool.str(call), defined.count(call) != 0);
+        }
+    }
+    if (!undefined.empty()) {
+        throw LinkError(undefined);
+    }
+
+    std::string program;
+    program.reserve(size);
+    program.append(BOOTSTRAP);
+    for (const AsmModule* module : modules) {
+        program.append(module->code);
+    }
+    return program;
+}
+
+}
@@ -0,0 +1,155 @@
+#include "Inliner.hpp"
+#include "CompilerResources.hpp"
+
+#include <algorithm>
+
+namespace Compiler {
+
+static bool isSegment(const VMInstruction& instruction, Segment segment) {
+    return (instruction.op == VMOp::PUSH || instruction.op == VMOp::POP)
+        && instruction.detail == static_cast<std::uint8_t>(segment);
+}
+
+static bool isLabelCommand(const VMInstruction& instruction) {
+    return instruction.op == VMOp::LABEL || instruction.op == VMOp::GOTO || instruction.op == VMOp::IF;
+}
+
+static int maxLabel(const std::vector<VMInstruction>& code) {
+    int label { -1 };
+    for (const VMInstruction& instruction : code) {
+        if (isLabelCommand(instruction)) {
+            label = std::max(label, instruction.arg);
+        }
+    }
+    return label;
+}
+
+Inliner::Inliner(const std::vector<VMFunction*>& program, unsigned maxSize) :
+    functions(program),
+    limit(maxSize) {}
+
+// candidates make no calls, so inlining never changes them and their bodies can be copied while callers change
+void Inliner::run() {
+    for (const VMFunction* function : functions) {
+        if (isInlinable(*function)) {
+            candidates.emplace(function->name, function);
+        }
+    }
+    if (candidates.empty()) { return; }
+
+    for (VMFunction* function : functions) {
+        inlineCalls(*function);
+    }
+}
+
+const std::vector<InlinedFunction>& Inliner::getInlined() const {
+    return inlined;
+}
+
+bool Inliner::isInlinable(const VMFunction& function) const {
+    const std::vector<VMInstruction>& code { function.code };
+    if (code.empty() || code.back().op != VMOp::RETURN || code.size() - 1 > limit) { return false; }
+    if (function.nVars > TEMP_COUNT) { return false; }
+
+    for (const VMInstruction& instruction : code) {
+        if (instruction.op == VMOp::CALL) { return false; }
+        if (isSegment(instruction, Segment::STATIC) || isSegment(instruction, Segment::THAT) || isSegment(instruction, Segment::TEMP)) {
+            return false;
+        }
+        if (isSegment(instruction, Segment::POINTER) && instruction.arg != 0) { return false; }
+    }
+    return true;
+}
+
+bool Inliner::takesObjectFromStack(const VMFunction& callee, int nArgs) const {
+    if (nArgs != 1 || !isSegment(callee.code[0], Segment::ARG) || callee.code[0].op != VMOp::PUSH) { return false; }
+
+    std::size_t uses { 0 };
+    for (const VMInstruction& instruction : callee.code) {
+        uses += isSegment(instruction, Segment::ARG) ? 1 : 0;
+    }
+    return uses == 1;
+}
+
+bool Inliner::fits(const VMFunction& callee, int nArgs) const {
+    for (const VMInstruction& instruction : callee.code) {
+        if (isSegment(instruction, Segment::ARG) && instruction.arg >= nArgs) { return false; }
+    }
+
+    int temps { takesObjectFromStack(callee, nArgs) ? callee.nVars : nArgs + callee.nVars };
+    return temps <= TEMP_COUNT;
+}
+
+void Inliner::inlineCalls(VMFunction& caller) {
+    int labelBase { maxLabel(caller.code) + 1 };
+    std::vector<VMInstruction> code;
+    code.reserve(caller.code.size());
+
+    for (const VMInstruction& instruction : caller.code) {
+        auto candidate { instruction.op == VMOp::CALL ? candidates.find(instruction.name) : candidates.end() };
+        if (candidate == candidates.end() || !fits(*candidate->second, instruction.arg)) {
+            code.push_back(instruction);
+            continue;
+        }
+
+        const VMFunction& callee { *candidate->second };
+        expand(callee, instruction.arg, labelBase, code);
+        labelBase += maxLabel(callee.code) + 2;
+
+        auto [entry, isNew] { inlinedIndex.emplace(callee.name, inlined.size()) };
+        if (isNew) {
+            inlined.push_back(InlinedFunction { callee.name, 0 });
+        }
+        ++inlined[entry->second].callSites;
+    }
+
+    caller.code = std::move(code);
+}
+
+// labels of the body become labelBase + label, and labelBase + (largest label + 1) ends the body
+void Inliner::expand(const VMFunction& callee, int nArgs, int labelBase, std::vector<VMInstruction>& out) const {
+    const std::vector<VMInstruction>& body { callee.code };
+    bool objectOnStack { takesObjectFromStack(callee, nArgs) };
+    int localBase { TEMP_BASE + (objectOnStack ? 0 : nArgs) };
+    int endLabel { labelBase + maxLabel(body) + 1 };
+
+    if (!objectOnStack) {
+        for (int i = nArgs - 1; i >= 0; --i) {
+            out.push_back({VMOp::POP, static_cast<std::uint8_t>(Segment::TEMP), TEMP_BASE + i, 0});
+        }
+    }
+    for (int i = 0; i < callee.nVars; ++i) {
+        out.push_back({VMOp::PUSH, static_cast<std::uint8_t>(Segment::CONST), 0, 0});
+        out.push_back({VMOp::POP, static_cast<std::uint8_t>(Segment::TEMP), localBase + i, 0});
+    }
+
+    bool earlyReturn { false };
+    for (std::size_t i = objectOnStack ? 1 : 0; i + 1 < body.size(); ++i) {
+        VMInstruction instruction { body[i] };
+
+        if (isSegment(instruction, Segment::ARG)) {
+            instruction.detail = static_cast<std::uint8_t>(Segment::TEMP);
+            instruction.arg += TEMP_BASE;
+        } else if (isSegment(instruction, Segment::LOCAL)) {
+            instruction.detail = static_cast<std::uint8_t>(Segment::TEMP);
+            instruction.arg += localBase;
+        } else if (isSegment(instruction, Segment::THIS)) {
+            instruction.detail = static_cast<std::uint8_t>(Segment::THAT);
+        } else if (isSegment(instruction, Segment::POINTER)) {
+            instruction.arg = 1;
+        } else if (isLabelCommand(instruction)) {
+            instruction.arg += labelBase;
+        } else if (instruction.op == VMOp::RETURN) {
+            instruction = {VMOp::GOTO, 0, endLabel, 0};
+            earlyReturn = true;
+        }
+
+        out.push_back(instruction);
+    }
+
+    if (earlyReturn) {
+        out.push_back({VMOp::LABEL, 0, endLabel, 0});
+    }
+}
+
+}
@@ -0,0 +1,77 @@
+#include "InternPool.hpp"
+
+#include <mutex>
+
+namespace Compiler {
+
+// must match the order of the BuiltinName handles
+static constexpr std::string_view BUILTIN_NAMES[] {
+    "this",
+    "Math.multiply",
+    "Math.divide",
+    "Memory.alloc",
+    "String.new",
+    "String.appendChar"
+};
+
+InternPool::InternPool() {
+    lookup.reserve(INITIAL_CAPACITY);
+    qualified.reserve(INITIAL_CAPACITY);
+    for (std::string_view str : BUILTIN_NAMES) {
+        intern(str);
+    }
+}
+
+Name InternPool::intern(std::string_view str) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it { lookup.find(str) };
+        if (it != lookup.end()) {
+            return it->second;
+        }
+    }
+
+    // another thread may have added the same string between the two locks
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it { lookup.find(str) };
+    if (it != lookup.end()) {
+        return it->second;
+    }
+
+    Name name { static_cast<Name>(strings.size()) };
+    const std::string& stored { strings.emplace_back(str) };
+    lookup.emplace(stored, name);
+    return name;
+}
+
+Name InternPool::qualify(Name className, Name memberName) {
+    std::uint64_t key { static_cast<std::uint64_t>(className) << 32 | memberName };
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it { qualified.find(key) };
+        if (it != qualified.end()) {
+            return it->second;
+        }
+    }
+
+    std::string fullName { str(className) };
+    fullName += '.';
+    fullName += str(memberName);
+
+    Name name { intern(fullName) };
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    qualified.emplace(key, name);
+    return name;
+}
+
+std::string_view InternPool::str(Name name) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return strings[name];
+}
+
+std::size_t InternPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return strings.size();
+}
+
+}
@@ -0,0 +1,146 @@
+#include "InvariantHoister.hpp"
+#include "CompilerResources.hpp"
+
+namespace Compiler {
+
+InvariantHoister::InvariantHoister(AST& tree) :
+    ast(tree),
+    subroutine(nullptr),
+    hoisted(0) {}
+
+void InvariantHoister::run() {
+    for (SubroutineDec& dec : ast.subroutines) {
+        subroutine = &dec;
+        visitBlock(dec.body);
+    }
+    subroutine = nullptr;
+}
+
+int InvariantHoister::getHoisted() const {
+    return hoisted;
+}
+
+// statements are tracked by their predecessor, since hoisting links new statements in before a loop
+void InvariantHoister::visitBlock(NodeId block) {
+    NodeId previous { NO_NODE };
+    for (NodeId statement = ast[block].firstChild; statement != NO_NODE; statement = ast[statement].nextSibling) {
+        if (ast[statement].kind == NodeKind::IF) {
+            visitBlock(ast.child(statement, 1));
+            NodeId elseBlock { ast.child(statement, 2) };
+            if (elseBlock != NO_NODE) {
+                visitBlock(elseBlock);
+            }
+        } else if (ast[statement].kind == NodeKind::WHILE) {
+            visitBlock(ast.child(statement, 1));
+            hoistFromLoop(block, previous, statement);
+        }
+        previous = statement;
+    }
+}
+
+void InvariantHoister::hoistFromLoop(NodeId block, NodeId previous, NodeId loop) {
+    LoopEffects effects;
+    collectEffects(loop, effects);
+
+    replaceInvariants(loop, effects, block, previous);
+}
+
+void InvariantHoister::collectEffects(NodeId node, LoopEffects& effects) const {
+    if (ast[node].kind == NodeKind::CALL) {
+        effects.hasCalls = true;
+    } else if (ast[node].kind == NodeKind::LET) {
+        NodeId target { ast.child(node, 0) };
+        if (ast[target].kind == NodeKind::VAR) {
+            effects.assigned.insert(variableKey(ast[target]));
+        } else {
+            effects.hasMemoryWrites = true;
+        }
+    }
+
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        collectEffects(child, effects);
+    }
+}
+
+/*
+The invariant expression is copied to a new node that becomes the value of "let local = expression", linked in
+after previous, and the original node is rewritten in place into a read of the local, so its parent's links and
+its own next sibling stay valid. Nodes are only referred to by index, as adding nodes may move the arena.
+*/
+void InvariantHoister::replaceInvariants(NodeId node, const LoopEffects& effects, NodeId block, NodeId& previous) {
+    NodeKind kind { ast[node].kind };
+    if ((kind == NodeKind::UNARY || kind == NodeKind::BINARY) && isInvariant(node, effects)) {
+        int local { subroutine->nLocals++ };
+
+        NodeId value { ast.addNode(kind, ast[node].op, ast[node].value) };
+        ast[value].firstChild = ast[node].firstChild;
+
+        NodeId target { ast.addNode(NodeKind::VAR, static_cast<std::uint8_t>(Segment::LOCAL), static_cast<std::uint32_t>(local)) };
+        NodeId let { ast.addNode(NodeKind::LET) };
+        ast.adopt(let, {target, value});
+
+        if (previous == NO_NODE) {
+            ast[let].nextSibling = ast[block].firstChild;
+            ast[block].firstChild = let;
+        } else {
+            ast[let].nextSibling = ast[previous].nextSibling;
+            ast[previous].nextSibling = let;
+        }
+        previous = let;
+
+        ast[node].kind = NodeKind::VAR;
+        ast[node].op = static_cast<std::uint8_t>(Segment::LOCAL);
+        ast[node].value = static_cast<std::uint32_t>(local);
+        ast[node].firstChild = NO_NODE;
+
+        ++hoisted;
+        return;
+    }
+
+    // a whole condition stays in place, where the code generator can still branch on its comparison
+    if (kind == NodeKind::IF || kind == NodeKind::WHILE) {
+        NodeId condition { ast[node].firstChild };
+        for (NodeId child = ast[condition].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+            replaceInvariants(child, effects, block, previous);
+        }
+        for (NodeId child = ast[condition].nextSibling; child != NO_NODE; child = ast[child].nextSibling) {
+            replaceInvariants(child, effects, block, previous);
+        }
+        return;
+    }
+
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        replaceInvariants(child, effects, block, previous);
+    }
+}
+
+bool InvariantHoister::isInvariant(NodeId node, const LoopEffects& effects) const {
+    const Node& n { ast[node] };
+    switch (n.kind) {
+        case NodeKind::INT_CONST:
+        case NodeKind::KEYWORD_CONST:
+            return true;
+        case NodeKind::VAR:
+            if (effects.assigned.count(variableKey(n)) > 0) { return false; }
+            if (n.segment() == Segment::LOCAL || n.segment() == Segment::ARG) { return true; }
+            return !effects.hasCalls && !effects.hasMemoryWrites;
+        case NodeKind::UNARY:
+            break;
+        case NodeKind::BINARY:
+            if (n.symbol() == Symbol::SLASH) { return false; }
+            break;
+        default:
+            return false;
+    }
+
+    for (NodeId child = n.firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        if (!isInvariant(child, effects)) { return false; }
+    }
+    return true;
+}
+
+std::uint32_t InvariantHoister::variableKey(const Node& var) {
+    return static_cast<std::uint32_t>(var.op) << 16 | var.value;
+}
+
+}
@@ -1,6 +1,23 @@
 #include "JackCompiler.hpp"
+#include "BuildCache.hpp"
 #include "CompilationEngine.hpp"
 #include "CompilerResources.hpp"
+#include "ControlFlowOptimizer.hpp"
+#include "HackAssembler.hpp"
+#include "HackWriter.hpp"
+#include "Inliner.hpp"
+#include "PeepholeOptimizer.hpp"
+#include "ThreadPool.hpp"
+#include "VMRecorder.hpp"
+#include "VMWriter.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Compiler {
 
@@ -8,26 +25,142 @@ namespace fs = std::filesystem;
 
 const fs::path JackCompiler::DEBUG_FILE { "debug.txt" };
 
-void JackCompiler::compile (const fs::path& sourceFile, bool debugMode) {
-    TokenSet::init();
-
+std::size_t JackCompiler::compile(const fs::path& sourceFile, const CompilerOptions& options) {
+    fs::path sourceDir;
     if (sourceFile.extension() == ".jack") {
         files.push_back(sourceFile);
+        sourceDir = sourceFile.has_parent_path() ? sourceFile.parent_path() : fs::path(".");
     } else {
         getJackFiles(sourceFile);
+        sourceDir = sourceFile;
+    }
+
+    // the debug file needs every symbol table, so with -d nothing is skipped but the cache is still refreshed
+    std::optional<BuildCache> cache;
+    std::vector<std::uint64_t> keys(files.size());
+    std::vector<std::size_t> pending;
+    if (options.useCache && !isWholeProgram(options.format) && !isWholeProgramAnalysis(options)) {
+        cache.emplace(sourceDir, options);
+    }
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (cache) {
+            keys[i] = cache->key(files[i]);
+            if (!options.debugMode && cache->isFresh(files[i], outputPath(files[i], options.format), keys[i])) { continue; }
+        }
+        pending.push_back(i);
     }
 
-    std::ofstream debugFile;
-    if (debugMode) {
-        debugFile = std::ofstream(DEBUG_FILE);
+    std::vector<FileResult> results(files.size());
+    if (options.jobs > 1 && pending.size() > 1) {
+        compileParallel(pending, results, options);
+    } else {
+        for (std::size_t i : pending) {
+            compileFile(files[i], results[i], options);
+        }
+    }
+
+    // debug output and errors are reported in file order regardless of which thread finished first
+    if (options.debugMode) {
+        std::ofstream debugFile(DEBUG_FILE);
+        for (const FileResult& result : results) {
+            debugFile << result.debugLog.str();
+        }
     }
-    std::ofstream* const debugPtr { debugMode ? &debugFile : nullptr };
 
-    for (fs::path infile : files) {
-        fs::path outfile { infile };
-        outfile.replace_extension(".vm");
-        compileFile(infile, outfile, debugPtr);
+    if (options.reportStats) {
+        reportStats(pending, results);
     }
+
+    std::size_t nFailed { 0 };
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (results[i].error.empty()) { continue; }
+
+        std::cerr << files[i].string() << ": " << results[i].error;
+        if (results[i].error.back() != '\n') { std::cerr << '\n'; }
+        ++nFailed;
+    }
+
+    if (isWholeProgramAnalysis(options) && nFailed == 0 && !writeProgram(sourceFile, results, options)) {
+        ++nFailed;
+    }
+
+    if (isWholeProgram(options.format) && nFailed == 0 && !linkProgram(sourceFile, results, options)) {
+        ++nFailed;
+    }
+
+    if (cache) {
+        for (std::size_t i : pending) {
+            if (results[i].error.empty()) {
+                cache->update(files[i], outputPath(files[i], options.format), keys[i]);
+            }
+        }
+        cache->save();
+
+        std::cout << "Build cache: " << files.size() - pending.size() << " up to date, " << pending.size() << " compiled\n";
+    }
+    return nFailed;
+}
+
+// the program is named after the source directory, as the VM translator names it, or after the single source file
+bool JackCompiler::linkProgram(const fs::path& sourceFile, const std::vector<FileResult>& results, const CompilerOptions& options) {
+    fs::path programFile;
+    if (sourceFile.extension() == ".jack") {
+        programFile = outputPath(sourceFile, options.format);
+    } else {
+        fs::path dirname { fs::absolute(sourceFile).lexically_normal() };
+        if (!dirname.has_filename()) { dirname = dirname.parent_path(); }
+        programFile = sourceFile / dirname.filename();
+        programFile += VMWriter::extension(options.format);
+    }
+
+    std::vector<const AsmModule*> modules;
+    for (const FileResult& result : results) {
+        modules.push_back(&result.assembly);
+    }
+
+    try {
+        std::string program { HackWriter::link(modules, pool) };
+        if (options.format == OutputFormat::HACK) {
+            program = HackAssembler(program).assemble();
+        }
+
+        std::ofstream outfile(programFile, std::ios::binary);
+        outfile.write(program.data(), static_cast<std::streamsize>(program.size()));
+    } catch (const JackCompilerError& error) {
+        std::cerr << programFile.string() << ": " << error.what();
+        return false;
+    }
+    return true;
+}
+
+void JackCompiler::reportStats(const std::vector<std::size_t>& compiled, const std::vector<FileResult>& results) const {
+    for (std::size_t i : compiled) {
+        if (!results[i].error.empty()) { continue; }
+
+        const OptimizationStats& stats { results[i].stats };
+        std::cout << files[i].string() << ": " << stats.mathCallsRemoved << " Math calls removed, "
+                  << stats.invariantsHoisted << " loop invariants hoisted, "
+                  << stats.subexpressionsReused << " subexpressions reused, "
+                  << stats.stringsPooled << " string literals pooled";
+
+        int rewrites { 0 };
+        for (int hits : stats.peepholeHits) { rewrites += hits; }
+        std::cout << ", " << rewrites << " peephole rewrites";
+        for (std::size_t rule = 0; rule < stats.peepholeHits.size(); ++rule) {
+            if (stats.peepholeHits[rule] > 0) {
+                std::cout << ' ' << PeepholeOptimizer::ruleName(rule) << '=' << stats.peepholeHits[rule];
+            }
+        }
+        std::cout << ", " << stats.flow.unreachableBlocks << " unreachable blocks removed, "
+                  << stats.flow.jumpsThreaded << " jumps threaded, " << stats.flow.jumpsRemoved << " jumps removed, "
+                  << stats.flow.blocksMerged << " blocks merged, " << stats.localsRemoved << " local slots removed\n";
+    }
+}
+
+fs::path JackCompiler::outputPath(const fs::path& infile, OutputFormat format) {
+    fs::path outfile { infile };
+    outfile.replace_extension(VMWriter::extension(format));
+    return outfile;
 }
 
 void JackCompiler::getJackFiles(const fs::path& dirname) {
@@ -38,8 +171,161 @@ void JackCompiler::getJackFiles(const fs::path& dirname) {
     }
 }
 
-void JackCompiler::compileFile(const fs::path& infile, const fs::path& outfile, std::ofstream* const debugFile) const {
-    CompilationEngine compiler(infile, outfile, debugFile);
+// runs as a thread pool task with -j, so every exception, such as std::bad_alloc, is reported as an error of the file
+void JackCompiler::compileFile(const fs::path& infile, FileResult& result, const CompilerOptions& options) {
+    fs::path outfile { outputPath(infile, options.format) };
+
+    try {
+        std::unique_ptr<VMWriter> writer;
+        if (isWholeProgramAnalysis(options)) {
+            writer = std::make_unique<VMRecorder>(result.functions);
+        } else {
+            writer = createWriter(infile, result, options);
+        }
+
+        CompilationEngine compiler(infile, std::move(writer), pool, options, options.debugMode ? &result.debugLog : nullptr);
+        result.stats = compiler.getStats();
+    } catch (const std::exception& error) {
+        result.error = error.what();
+
+        // do not leave a partial VM file behind; whole-program analysis writes nothing until every file compiles
+        if (!isWholeProgram(options.format) && !isWholeProgramAnalysis(options)) {
+            std::error_code removeError;
+            fs::remove(outfile, removeError);
+        }
+    }
+}
+
+std::unique_ptr<VMWriter> JackCompiler::createWriter(const fs::path& infile, FileResult& result, const CompilerOptions& options) {
+    if (isWholeProgram(options.format)) {
+        return std::make_unique<HackWriter>(result.assembly, pool, infile.stem().string());
+    }
+    return VMWriter::create(outputPath(infile, options.format), pool, options.format);
+}
+
+// the recorded functions are changed in place by inlining, then written, skipping those that pruning removes
+bool JackCompiler::writeProgram(const fs::path& sourceFile, std::vector<FileResult>& results, const CompilerOptions& options) {
+    std::vector<VMFunction*> program;
+    for (FileResult& result : results) {
+        for (VMFunction& function : result.functions) {
+            program.push_back(&function);
+        }
+    }
+
+    if (options.inlineLimit > 0) {
+        Inliner inliner(program, options.inlineLimit);
+        inliner.run();
+        reportInlined(inliner.getInlined());
+    }
+
+    std::unordered_set<Name> reachable;
+    if (options.prune && !findReachable(sourceFile, program, reachable)) {
+        return false;
+    }
+
+    std::vector<Name> removed;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        std::unique_ptr<VMWriter> writer { createWriter(files[i], results[i], options) };
+
+        // inlined bodies are cleaned up by the same stages that optimized each function the first time
+        if (options.optimize && options.inlineLimit > 0) {
+            writer = std::make_unique<PeepholeOptimizer>(std::make_unique<ControlFlowOptimizer>(std::move(writer)));
+        }
+
+        try {
+            for (const VMFunction& function : results[i].functions) {
+                if (!options.prune || reachable.count(function.name) != 0) {
+                    VMRecorder::replay(function, *writer);
+                } else {
+                    removed.push_back(function.name);
+                }
+            }
+            writer->finish();
+        } catch (const JackCompilerError& error) {
+            std::cerr << files[i].string() << ": " << error.what();
+            return false;
+        }
+    }
+
+    if (options.prune) {
+        std::cout << "Pruned " << removed.size() << " of " << program.size() << " functions";
+        std::cout << (removed.empty() ? "\n" : ":\n");
+        for (Name function : removed) {
+            std::cout << "    " << pool.str(function) << '\n';
+        }
+    }
+    return true;
+}
+
+/*
+Functions are reachable from Sys.init, which the bootstrap calls, and from Main.main, which the OS's Sys.init calls.
+Jack has no function values, so the calls recorded in each function are all of its edges in the call graph; calls
+to functions outside the compiled classes, such as a prebuilt OS, end the search.
+*/
+bool JackCompiler::findReachable(const fs::path& sourceFile, const std::vector<VMFunction*>& program, std::unordered_set<Name>& reachable) {
+    std::unordered_map<Name, const VMFunction*> defined;
+    for (const VMFunction* function : program) {
+        defined.emplace(function->name, function);
+    }
+
+    std::vector<Name> worklist;
+    for (Name root : {pool.intern("Sys.init"), pool.intern("Main.main")}) {
+        if (defined.count(root) != 0 && reachable.insert(root).second) {
+            worklist.push_back(root);
+        }
+    }
+    if (worklist.empty()) {
+        std::cerr << sourceFile.string() << ": --prune needs a Sys.init or Main.main function\n";
+        return false;
+    }
+
+    while (!worklist.empty()) {
+        const VMFunction& function { *defined.at(worklist.back()) };
+        worklist.pop_back();
+
+        for (const VMInstruction& instruction : function.code) {
+            if (instruction.op == VMOp::CALL && defined.count(instruction.name) != 0 && reachable.insert(instruction.name).second) {
+                worklist.push_back(instruction.name);
+            }
+        }
+    }
+    return true;
+}
+
+void JackCompiler::reportInlined(const std::vector<InlinedFunction>& inlined) const {
+    int callSites { 0 };
+    for (const InlinedFunction& function : inlined) {
+        callSites += function.callSites;
+    }
+
+    std::cout << "Inlined " << callSites << " call sites of " << inlined.size() << " functions";
+    std::cout << (inlined.empty() ? "\n" : ":\n");
+    for (const InlinedFunction& function : inlined) {
+        std::cout << "    " << pool.str(function.name) << " x" << function.callSites << '\n';
+    }
+}
+
+// largest files are queued first so a big file never starts last and leaves the other workers idle
+void JackCompiler::compileParallel(const std::vector<std::size_t>& pending, std::vector<FileResult>& results, const CompilerOptions& options) {
+    std::vector<std::uintmax_t> sizes(files.size());
+    for (std::size_t i : pending) {
+        std::error_code error;
+        sizes[i] = fs::file_size(files[i], error);
+        if (error) { sizes[i] = 0; }
+    }
+
+    std::vector<std::size_t> order(pending);
+    std::stable_sort(order.begin(), order.end(), [&sizes](std::size_t a, std::size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    ThreadPool workers(std::min<std::size_t>(options.jobs, pending.size()));
+    for (std::size_t i : order) {
+        workers.submit([this, i, &results, &options] {
+            compileFile(files[i], results[i], options);
+        });
+    }
+    workers.wait();
 }
 
 }
@@ -0,0 +1,473 @@
+#include "JackParser.hpp"
+#include "AST.hpp"
+#include "CompilerResources.hpp"
+#include "JackTokenizer.hpp"
+#include "SymbolTable.hpp"
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+JackParser::JackParser(const fs::path& infile, InternPool& namePool, std::ostream* const debugFile) :
+    pool(namePool),
+    tokenizer(infile, namePool),
+    ast(nullptr),
+    classSymbols(namePool, debugFile),
+    methodSymbols(namePool, debugFile) {}
+
+// 'class' className '{' classVarDec* subroutineDec* '}'
+void JackParser::parseClass(AST& tree) {
+    ast = &tree;
+    ast->reserve(tokenizer.sourceSize() / BYTES_PER_NODE);
+
+    process(Keyword::CLASS);
+    currClassName = parseName();
+    ast->className = currClassName;
+    process(Symbol::CURLBRACE_L);
+    while (isClassVarDec()) { parseClassVarDec(); }
+    ast->nFields = classSymbols.varCount(Segment::THIS);
+    ast->nStatics = classSymbols.varCount(Segment::STATIC);
+    while (isSubroutineDec()) { parseSubroutine(); }
+    process(Symbol::CURLBRACE_R);
+
+    classSymbols.dumpTable(currClassName, "class");
+}
+
+void JackParser::handleInvalidToken(const Token& token, const TokenReq& req, const std::string* customReqName) const {
+    std::string reqName { customReqName ? *customReqName : reqToString(req) };
+
+    if (!req.anyValue) {
+        throw TokenError(std::string(tokenizer.text(token)), reqName);
+    } else {
+        throw WildcardTokenError(+token.type, reqName);
+    }
+}
+
+bool JackParser::compareToken(const Token& token, const TokenReq& req) const {
+    return token.type == req.type && (req.anyValue || token.value == req.value);
+}
+
+const Token& JackParser::process(const TokenReq& req) {
+    const Token& token { tokenizer.advance() };
+    if (compareToken(token, req)) {
+        return token;
+    }
+
+    handleInvalidToken(token, req);
+}
+
+bool JackParser::nextTokenIs(const TokenReq& req) const {
+    return compareToken(tokenizer.nextToken(), req);
+}
+
+bool JackParser::nextTokenIsOneOf(const TokenReqSet& reqs) const {
+    return reqs.contains(tokenizer.nextToken());
+}
+
+Keyword JackParser::processKeyword() {
+    return process(TokenType::KEYWORD).keyword();
+}
+
+Symbol JackParser::processSymbol() {
+    return process(TokenType::SYMBOL).symbol();
+}
+
+int JackParser::processIntConst() {
+    return process(TokenType::INT_CONST).intVal();
+}
+
+std::string_view JackParser::processStringConst() {
+    return tokenizer.text( process(TokenType::STRING_CONST) );
+}
+
+Name JackParser::processIdentifier() {
+    return process(TokenType::IDENTIFIER).name();
+}
+
+const Token& JackParser::verifySet(const TokenReqSet& reqs, const std::string& setName) {
+    if (nextTokenIsOneOf(reqs)) {
+        return tokenizer.advance();
+    }
+
+    throw TokenError(std::string(tokenizer.text(tokenizer.nextToken())), setName);
+}
+
+const Token& JackParser::verifyVarType() {
+    return verifySet(TokenSet::DATA_TYPES, "var type");
+}
+
+const Token& JackParser::verifyReturnType() {
+    return verifySet(TokenSet::RETURN_TYPES, "return type");
+}
+
+bool JackParser::isClassVarDec() const {
+    return nextTokenIsOneOf(TokenSet::CLASS_VAR_DEC);
+}
+
+bool JackParser::isSubroutineDec() const {
+    return nextTokenIsOneOf(TokenSet::SUBROUTINE_DEC);
+}
+
+bool JackParser::isVarDec() const {
+    return nextTokenIs(Keyword::VAR);
+}
+
+bool JackParser::isStatement() const {
+    return nextTokenIsOneOf(TokenSet::STATEMENTS);
+}
+
+bool JackParser::termIsSubroutineCall() const {
+    return TokenSet::SUBROUTINE_CALL.contains(tokenizer.peekSecond());
+}
+
+bool JackParser::termIsArrayExp() const {
+    return compareToken(tokenizer.nextToken(), Symbol::SQRBRACK_L);
+}
+
+// identifier types already carry their handle; keyword types are interned by their text
+Name JackParser::typeName(const Token& token) {
+    return token.type == TokenType::IDENTIFIER ? token.name() : pool.intern(tokenizer.text(token));
+}
+
+const SymbolTable* JackParser::getVarScope(Name name) const {
+    if (methodSymbols.contains(name)) {
+        return &methodSymbols;
+    } else if (classSymbols.contains(name)) {
+        return &classSymbols;
+    } else {
+        return nullptr;
+    }
+}
+
+// children of variable-length lists are collected on the pending stack above mark, then linked under their parent
+NodeId JackParser::adoptPending(NodeId parent, std::size_t mark) {
+    ast->adopt(parent, pending.data() + mark, pending.data() + pending.size());
+    pending.resize(mark);
+    return parent;
+}
+
+// ( 'static' | 'field' ) type varName ( ',' varName )* ';'
+void JackParser::parseClassVarDec() {
+    Segment symbolSegment { keywordToSegment( processKeyword() ) };
+    Name symbolType { typeName( verifyVarType() ) };
+
+    while (true) {
+        parseVarName(symbolType, symbolSegment, classSymbols);
+        if (!nextTokenIs(Symbol::COMMA)) { break; }
+        process(Symbol::COMMA);
+    }
+    process(Symbol::SEMICOLON);
+}
+
+// ( 'constructor' | 'function' | 'method' ) ( 'void' | type ) subroutineName '(' parameterList ')' subroutineBody
+void JackParser::parseSubroutine() {
+    Keyword subroutineType { processKeyword() };
+    verifyReturnType();
+    Name subroutineName { parseName() };
+
+    methodSymbols.reset();
+    // methods take this object as implicit first argument
+    if (subroutineType == Keyword::METHOD) { methodSymbols.defineThisObject(currClassName); }
+
+    process(Symbol::PAREN_L);
+    parseParameterList();
+    process(Symbol::PAREN_R);
+    NodeId body { parseSubroutineBody() };
+
+    ast->subroutines.push_back(SubroutineDec {
+        pool.qualify(currClassName, subroutineName),
+        subroutineType,
+        methodSymbols.varCount(Segment::LOCAL),
+        body
+    });
+
+    methodSymbols.dumpTable(subroutineName, "method");
+}
+
+// ( ( type varName ) ( ',' type varName )* )?
+void JackParser::parseParameterList() {
+    if (nextTokenIs(Symbol::PAREN_R)) { return; }
+    while (true) {
+        Name symbolType { typeName( verifyVarType() ) };
+        parseVarName(symbolType, Segment::ARG, methodSymbols);
+        if (!nextTokenIs(Symbol::COMMA)) { break; }
+        process(Symbol::COMMA);
+    }
+}
+
+// '{' varDec* statements '}'
+NodeId JackParser::parseSubroutineBody() {
+    process(Symbol::CURLBRACE_L);
+    while (isVarDec()) { parseVarDec(); }
+    NodeId body { parseStatements() };
+    process(Symbol::CURLBRACE_R);
+    return body;
+}
+
+// 'var' type varName ( ',' varName )* ';'
+void JackParser::parseVarDec() {
+    process(Keyword::VAR);
+    Name symbolType { typeName( verifyVarType() ) };
+    while (true) {
+        parseVarName(symbolType, Segment::LOCAL, methodSymbols);
+        if (!nextTokenIs(Symbol::COMMA)) { break; }
+        process(Symbol::COMMA);
+    }
+    process(Symbol::SEMICOLON);
+}
+
+Name JackParser::parseVarName(Name type, const Segment& segment, SymbolTable& symbolTable) {
+    Name name { processIdentifier() };
+    symbolTable.define(name, type, segment);
+    return name;
+}
+
+const SymbolTable::Entry* JackParser::parseVarName() {
+    Name name { processIdentifier() };
+    if (const SymbolTable* symbolTable = getVarScope(name)) {
+        return symbolTable->getEntry(name);
+    }
+
+    throw SymbolError(std::string(pool.str(name)));
+}
+
+NodeId JackParser::addVarNode(const SymbolTable::Entry* entryPtr) {
+    return ast->addNode(NodeKind::VAR, static_cast<std::uint8_t>(entryPtr->segment), entryPtr->index);
+}
+
+Name JackParser::parseName() {
+    return processIdentifier();
+}
+
+// ( className | varName ) '.' subroutineName '(' expressionList ')'
+//                           | subroutineName '(' expressionList ')'
+NodeId JackParser::parseSubroutineCall() {
+    /*
+    internal method (no dot):   className is current class; this is the first arg
+    external method (varName):  className is type(varName); var is the first arg
+    external func (className):  className is provided; no extra arg
+    */
+
+    std::size_t mark { pending.size() };
+    Name className { currClassName };
+
+    if (compareToken(tokenizer.peekSecond(), Symbol::DOT)) {
+        Name symbolName { tokenizer.nextToken().name() };
+
+        if (getVarScope(symbolName)) {
+            const SymbolTable::Entry* entryPtr { parseVarName() };
+            pending.push_back(addVarNode(entryPtr));
+            className = entryPtr->type;
+        } else {
+            className = parseName();
+        }
+
+        process(Symbol::DOT);
+
+    } else {
+        pending.push_back(ast->addNode(NodeKind::KEYWORD_CONST, static_cast<std::uint8_t>(Keyword::THIS)));
+    }
+
+    Name subroutineName { parseName() };
+    process(Symbol::PAREN_L);
+    parseExpressionList();
+    process(Symbol::PAREN_R);
+
+    NodeId call { ast->addNode(NodeKind::CALL, 0, pool.qualify(className, subroutineName)) };
+    return adoptPending(call, mark);
+}
+
+// ( letStatement | ifStatement | whileStatement | doStatement | returnStatement )*
+NodeId JackParser::parseStatements() {
+    std::size_t mark { pending.size() };
+
+    while (isStatement()) {
+        switch (tokenizer.nextToken().keyword()) {
+            case Keyword::LET:    pending.push_back(parseLet());    break;
+            case Keyword::IF:     pending.push_back(parseIf());     break;
+            case Keyword::WHILE:  pending.push_back(parseWhile());  break;
+            case Keyword::DO:     pending.push_back(parseDo());     break;
+            case Keyword::RETURN: pending.push_back(parseReturn()); break;
+            default: break;
+        }
+    }
+
+    return adoptPending(ast->addNode(NodeKind::BLOCK), mark);
+}
+
+// 'let' varName ( '[' expression ']' )? '=' expression ';'
+NodeId JackParser::parseLet() {
+    process(Keyword::LET);
+    NodeId target { addVarNode( parseVarName() ) };
+
+    if (nextTokenIs(Symbol::SQRBRACK_L)) {
+        process(Symbol::SQRBRACK_L);
+        NodeId index { parseExpression() };
+        process(Symbol::SQRBRACK_R);
+
+        NodeId element { ast->addNode(NodeKind::ARRAY_ELEM) };
+        ast->adopt(element, {target, index});
+        target = element;
+    }
+
+    process(Symbol::EQUAL);
+    NodeId value { parseExpression() };
+    process(Symbol::SEMICOLON);
+
+    NodeId let { ast->addNode(NodeKind::LET) };
+    ast->adopt(let, {target, value});
+    return let;
+}
+
+// 'if' '(' expression ')' '{' statements '}' ( 'else' '{' statements '}' )?
+NodeId JackParser::parseIf() {
+    process(Keyword::IF);
+    process(Symbol::PAREN_L);
+    NodeId condition { parseExpression() };
+    process(Symbol::PAREN_R);
+
+    process(Symbol::CURLBRACE_L);
+    NodeId thenBlock { parseStatements() };
+    process(Symbol::CURLBRACE_R);
+
+    NodeId ifNode { ast->addNode(NodeKind::IF) };
+
+    if (nextTokenIs(Keyword::ELSE)) {
+        process(Keyword::ELSE);
+        process(Symbol::CURLBRACE_L);
+        NodeId elseBlock { parseStatements() };
+        process(Symbol::CURLBRACE_R);
+
+        ast->adopt(ifNode, {condition, thenBlock, elseBlock});
+    } else {
+        ast->adopt(ifNode, {condition, thenBlock});
+    }
+
+    return ifNode;
+}
+
+// 'while' '(' expression ')' '{' statements '}'
+NodeId JackParser::parseWhile() {
+    process(Keyword::WHILE);
+
+    process(Symbol::PAREN_L);
+    NodeId condition { parseExpression() };
+    process(Symbol::PAREN_R);
+
+    process(Symbol::CURLBRACE_L);
+    NodeId body { parseStatements() };
+    process(Symbol::CURLBRACE_R);
+
+    NodeId whileNode { ast->addNode(NodeKind::WHILE) };
+    ast->adopt(whileNode, {condition, body});
+    return whileNode;
+}
+
+// 'do' subroutineCall ';'
+NodeId JackParser::parseDo() {
+    process(Keyword::DO);
+    NodeId call { parseSubroutineCall() };
+    process(Symbol::SEMICOLON);
+
+    NodeId doNode { ast->addNode(NodeKind::DO) };
+    ast->adopt(doNode, {call});
+    return doNode;
+}
+
+// 'return' expression? ';'
+NodeId JackParser::parseReturn() {
+    process(Keyword::RETURN);
+    NodeId returnNode { ast->addNode(NodeKind::RETURN) };
+
+    if (!nextTokenIs(Symbol::SEMICOLON)) {
+        NodeId value { parseExpression() };
+        ast->adopt(returnNode, {value});
+    }
+
+    process(Symbol::SEMICOLON);
+    return returnNode;
+}
+
+// term ( op term )*
+NodeId JackParser::parseExpression() {
+    NodeId left { parseTerm() };
+
+    while (nextTokenIsOneOf(TokenSet::OPERATORS)) {
+        Symbol op { processSymbol() };
+        NodeId right { parseTerm() };
+
+        NodeId binary { ast->addNode(NodeKind::BINARY, static_cast<std::uint8_t>(op)) };
+        ast->adopt(binary, {left, right});
+        left = binary;
+    }
+
+    return left;
+}
+
+// intConst | stringConst | keywordConst | varName | varName '[' expression ']'
+// | subroutineCall | '(' expression ')' | unaryOp term
+NodeId JackParser::parseTerm() {
+    if (nextTokenIs(TokenType::INT_CONST)) {
+        return ast->addNode(NodeKind::INT_CONST, 0, processIntConst());
+    } else if (nextTokenIs(TokenType::STRING_CONST)) {
+        return ast->addNode(NodeKind::STRING_CONST, 0, ast->addString( processStringConst() ));
+    } else if (nextTokenIsOneOf(TokenSet::KEYWORD_CONSTANTS)) {
+        return parseKeywordConstTerm();
+    } else if (nextTokenIs(TokenType::IDENTIFIER)) {
+        return parseIdentifierTerm();
+    } else if (nextTokenIs(Symbol::PAREN_L)) {
+        process(Symbol::PAREN_L);
+        NodeId inner { parseExpression() };
+        process(Symbol::PAREN_R);
+        return inner;
+    } else if (nextTokenIsOneOf(TokenSet::UNARY_OPS)) {
+        Symbol op { processSymbol() };
+        NodeId operand { parseTerm() };
+
+        NodeId unary { ast->addNode(NodeKind::UNARY, static_cast<std::uint8_t>(op)) };
+        ast->adopt(unary, {operand});
+        return unary;
+    } else {
+        std::string reqName { "term" };
+        handleInvalidToken(tokenizer.nextToken(), TokenType::IDENTIFIER, &reqName);
+    }
+}
+
+// ( expression ( ',' expression )* )?
+void JackParser::parseExpressionList() {
+    if (!nextTokenIs(Symbol::PAREN_R)) {
+        while (true) {
+            pending.push_back(parseExpression());
+            if (!nextTokenIs(Symbol::COMMA)) { break; }
+            process(Symbol::COMMA);
+        }
+    }
+}
+
+// 'true' | 'false' | 'null' | 'this'
+NodeId JackParser::parseKeywordConstTerm() {
+    return ast->addNode(NodeKind::KEYWORD_CONST, static_cast<std::uint8_t>(processKeyword()));
+}
+
+// varName | varName '[' expression ']' | subroutineCall
+NodeId JackParser::parseIdentifierTerm() {
+    if (termIsSubroutineCall()) {
+        return parseSubroutineCall();
+    }
+
+    NodeId base { addVarNode( parseVarName() ) };
+
+    if (termIsArrayExp()) {
+        process(Symbol::SQRBRACK_L);
+        NodeId index { parseExpression() };
+        process(Symbol::SQRBRACK_R);
+
+        NodeId element { ast->addNode(NodeKind::ARRAY_ELEM) };
+        ast->adopt(element, {base, index});
+        return element;
+    }
+
+    return base;
+}
+
+}
@@ -2,96 +2,170 @@
 #include "CompilerResources.hpp"
 #include "utils.hpp"
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace Compiler {
 
 namespace fs = std::filesystem;
 
-std::regex JackTokenizer::tokenPattern = std::regex(R"(\d+|".*?"|[{}()\[\].,;+\-*/&|<>=~]|[a-zA-Z_]\w*)");
+JackTokenizer::JackTokenizer(const fs::path& infilePath, InternPool& namePool) :
+    source(infilePath),
+    pool(namePool),
+    head(0),
+    count(0) {
+    if (!source.isOpen()) {
+        throw FileError(infilePath.string());
+    }
 
-JackTokenizer::JackTokenizer(const fs::path& infilePath) {
-    std::ifstream infile(infilePath);
-    if (!infile) {
-        std::cerr << "Input file not opened\n";
-        exit(2);
+    std::string_view text { source.text() };
+    if (text.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw LexicalError("source file too large");
     }
 
-    std::stringstream buffer;
-    buffer << infile.rdbuf();
-    data = buffer.str();
-    infile.close();
+    base = text.data();
+    cursor = base;
+    end = base + text.size();
 
-    matchTokens();
+    fillWindow();
 }
 
 const Token& JackTokenizer::nextToken() const {
-    return tokens.front();
+    return peek(0);
 }
 
 bool JackTokenizer::hasMoreTokens() const {
-    return !tokens.empty();
+    return count > 0;
 }
 
 const Token& JackTokenizer::advance() {
-    currToken = tokens.front();
-    tokens.pop_front();
+    currToken = peek(0);
+    head = (head + 1) % LOOKAHEAD;
+    --count;
+    fillWindow();
     return currToken;
 }
 
 const Token& JackTokenizer::peekSecond() const {
-    return tokens[1];
-}
-
-TokenType JackTokenizer::getTokenType(const std::string& tokenVal) {
-    if (strToKeyword.find(tokenVal) != strToKeyword.end()) {
-        return TokenType::KEYWORD;
-    } else if (strToSymbol.find(tokenVal) != strToSymbol.end()) {
-        return TokenType::SYMBOL;
-    } else if (strIsDigit(tokenVal)) {
-        return TokenType::INT_CONST;
-    } else if (tokenVal[0] == '"' && tokenVal[tokenVal.length() - 1] == '"') {
-        return TokenType::STRING_CONST;
+    return peek(1);
+}
+
+std::string_view JackTokenizer::text(const Token& token) const {
+    return std::string_view(base + token.offset, token.length);
+}
+
+std::size_t JackTokenizer::sourceSize() const {
+    return static_cast<std::size_t>(end - base);
+}
+
+const Token& JackTokenizer::peek(std::size_t offset) const {
+    if (offset >= count) {
+        throw LexicalError("unexpected end of input");
+    }
+    return window[(head + offset) % LOOKAHEAD];
+}
+
+void JackTokenizer::fillWindow() {
+    while (count < LOOKAHEAD && matchToken(window[(head + count) % LOOKAHEAD])) {
+        ++count;
+    }
+}
+
+Token JackTokenizer::makeToken(TokenType type, std::uint32_t value, const char* begin, const char* last) const {
+    return Token(type, value, static_cast<std::uint32_t>(begin - base), static_cast<std::uint16_t>(last - begin));
+}
+
+void JackTokenizer::skipBlockComment() {
+    static const char CLOSE[] { "*/" };
+    const char* close { std::search(cursor + 2, end, CLOSE, CLOSE + 2) };
+    if (close == end) {
+        throw LexicalError("unterminated comment");
+    }
+    cursor = close + 2;
+}
+
+void JackTokenizer::matchIntConst(Token& token) {
+    const char* begin { cursor };
+    int value { 0 };
+    for (; cursor < end && isDigit(*cursor); ++cursor) {
+        value = value * 10 + (*cursor - '0');
+        if (value > MAX_INT_CONST) {
+            throw LexicalError("integer constant out of range");
+        }
+    }
+
+    token = makeToken(TokenType::INT_CONST, value, begin, cursor);
+}
+
+void JackTokenizer::matchStringConst(Token& token) {
+    const char* begin { cursor + 1 };
+    const char* close { std::find_if(begin, end, [](char chr) { return chr == '"' || chr == '\n'; }) };
+    if (close == end || *close != '"') {
+        throw LexicalError("unterminated string constant");
+    }
+
+    if (close - begin > std::numeric_limits<std::uint16_t>::max()) {
+        throw LexicalError("token too long");
+    }
+    token = makeToken(TokenType::STRING_CONST, 0, begin, close);
+    cursor = close + 1;
+}
+
+void JackTokenizer::matchWord(Token& token) {
+    const char* begin { cursor };
+    while (cursor < end && isIdentifierChar(*cursor)) { ++cursor; }
+
+    if (cursor - begin > std::numeric_limits<std::uint16_t>::max()) {
+        throw LexicalError("token too long");
+    }
+    std::string_view word(begin, cursor - begin);
+    if (std::optional<Keyword> keyword = strToKeyword(word)) {
+        token = makeToken(TokenType::KEYWORD, static_cast<std::uint32_t>(*keyword), begin, cursor);
     } else {
-        return TokenType::IDENTIFIER;
+        token = makeToken(TokenType::IDENTIFIER, pool.intern(word), begin, cursor);
     }
 }
 
-Token JackTokenizer::tokenize(const std::string &tokenVal) {
-    Token token;
-    TokenType tokenType { getTokenType(tokenVal) };
-    token.type = tokenType;
-
-    switch (tokenType) {
-    case TokenType::KEYWORD:
-        token.val = strToKeyword.at(tokenVal);
-        break;
-    case TokenType::SYMBOL:
-        token.val = strToSymbol.at(tokenVal);
-        break;
-    case TokenType::INT_CONST:
-        token.val = std::stoi(tokenVal);
-        break;
-    case TokenType::STRING_CONST:
-        token.val = tokenVal.substr(1, tokenVal.length() - 2);
-        break;
-    case TokenType::IDENTIFIER:
-        token.val = tokenVal;
-        break;
+bool JackTokenizer::matchSymbol(Token& token) {
+    const char* begin { cursor++ };
+    std::optional<Symbol> symbol { charToSymbol(*begin) };
+    if (!symbol) {
+        return false;
     }
 
-    return token;
+    token = makeToken(TokenType::SYMBOL, static_cast<std::uint32_t>(*symbol), begin, cursor);
+    return true;
 }
 
-void JackTokenizer::matchTokens() {
-    removeComments(data);
-    for (std::sregex_iterator it(data.begin(), data.end(), tokenPattern), end; it != end; ++it) {
-        std::smatch match { *it };
-        tokens.push_back(tokenize(match.str())); // tokenize return value out of scope??
+// scans forward to the next token: comments and whitespace are skipped in place, any other unrecognized character is ignored
+bool JackTokenizer::matchToken(Token& token) {
+    while (cursor < end) {
+        char chr { *cursor };
+
+        if (chr == ' ' || chr == '\t' || chr == '\n' || chr == '\r') {
+            ++cursor;
+        } else if (chr == '/' && cursor + 1 < end && cursor[1] == '/') {
+            cursor = std::find(cursor + 2, end, '\n');
+        } else if (chr == '/' && cursor + 1 < end && cursor[1] == '*') {
+            skipBlockComment();
+        } else if (isDigit(chr)) {
+            matchIntConst(token);
+            return true;
+        } else if (chr == '"') {
+            matchStringConst(token);
+            return true;
+        } else if (isIdentifierStart(chr)) {
+            matchWord(token);
+            return true;
+        } else if (matchSymbol(token)) {
+            return true;
+        }
     }
+
+    return false;
 }
 
 }
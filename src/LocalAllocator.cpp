@@ -0,0 +1,217 @@
+#include "LocalAllocator.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace Compiler {
+
+static constexpr int NO_SLOT { -1 };
+
+static bool contains(const std::uint64_t* set, int local) {
+    return (set[local / 64] >> (local % 64)) & 1;
+}
+
+static void insert(std::uint64_t* set, int local) {
+    set[local / 64] |= std::uint64_t { 1 } << (local % 64);
+}
+
+static void erase(std::uint64_t* set, int local) {
+    set[local / 64] &= ~(std::uint64_t { 1 } << (local % 64));
+}
+
+LocalAllocator::LocalAllocator(std::unique_ptr<VMWriter> output) :
+    writer(std::move(output)),
+    hasFunction(false),
+    functionName(0),
+    functionVars(0),
+    localsRemoved(0) {}
+
+LocalAllocator::~LocalAllocator() {
+    flush();
+}
+
+void LocalAllocator::writePush(const Segment& segment, const int index) {
+    code.push_back({VMOp::PUSH, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void LocalAllocator::writePop(const Segment& segment, const int index) {
+    code.push_back({VMOp::POP, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void LocalAllocator::writeArithmetic(const Command& command) {
+    code.push_back({VMOp::ARITHMETIC, static_cast<std::uint8_t>(command), 0, 0});
+}
+
+void LocalAllocator::writeLabel(const int label) {
+    code.push_back({VMOp::LABEL, 0, label, 0});
+}
+
+void LocalAllocator::writeGoto(const int label) {
+    code.push_back({VMOp::GOTO, 0, label, 0});
+}
+
+void LocalAllocator::writeIf(const int label) {
+    code.push_back({VMOp::IF, 0, label, 0});
+}
+
+void LocalAllocator::writeCall(Name name, const int nArgs) {
+    code.push_back({VMOp::CALL, 0, nArgs, name});
+}
+
+void LocalAllocator::writeFunction(Name name, const int nVars) {
+    flush();
+    hasFunction = true;
+    functionName = name;
+    functionVars = nVars;
+}
+
+void LocalAllocator::writeReturn() {
+    code.push_back({VMOp::RETURN, 0, 0, 0});
+}
+
+void LocalAllocator::finish() {
+    flush();
+    writer->finish();
+}
+
+void LocalAllocator::flush() {
+    if (!hasFunction) { return; }
+
+    std::vector<int> slots;
+    int nSlots { 0 };
+    if (functionVars > 0) {
+        std::size_t words { static_cast<std::size_t>(functionVars + 63) / 64 };
+        LiveSet liveIn;
+        LiveSet liveOut { analyzeLiveness(words, liveIn) };
+
+        // dead stores are discarded into scratch temp 0 and no longer count as definitions
+        for (std::size_t i = 0; i < code.size(); ++i) {
+            if (isLocal(code[i], VMOp::POP) && !contains(&liveOut[i * words], code[i].arg)) {
+                code[i].detail = static_cast<std::uint8_t>(Segment::TEMP);
+                code[i].arg = 0;
+            }
+        }
+
+        slots = assignSlots(words, liveOut, liveIn);
+        for (int slot : slots) {
+            nSlots = std::max(nSlots, slot + 1);
+        }
+        for (VMInstruction& instruction : code) {
+            if (isLocal(instruction, VMOp::PUSH) || isLocal(instruction, VMOp::POP)) {
+                instruction.arg = slots[instruction.arg];
+            }
+        }
+    }
+
+    localsRemoved += functionVars - nSlots;
+    writer->writeFunction(functionName, nSlots);
+    for (const VMInstruction& instruction : code) {
+        writer->write(instruction);
+    }
+
+    code.clear();
+    hasFunction = false;
+}
+
+int LocalAllocator::getLocalsRemoved() const {
+    return localsRemoved;
+}
+
+// backward dataflow over single commands: live-out is the union of the successors' live-in, iterated to a fixpoint;
+// the result holds one row of words per command
+LocalAllocator::LiveSet LocalAllocator::analyzeLiveness(std::size_t words, LiveSet& entryLive) const {
+    std::unordered_map<int, std::size_t> labels;
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        if (code[i].op == VMOp::LABEL) {
+            labels[code[i].arg] = i;
+        }
+    }
+
+    LiveSet liveIn((code.size() + 1) * words, 0);
+    LiveSet liveOut(code.size() * words, 0);
+    LiveSet in(words, 0);
+    bool changed { true };
+    while (changed) {
+        changed = false;
+        for (std::size_t i = code.size(); i-- > 0;) {
+            const VMInstruction& instruction { code[i] };
+            std::uint64_t* out { &liveOut[i * words] };
+
+            auto merge = [&](std::size_t successor) {
+                for (std::size_t w = 0; w < words; ++w) {
+                    std::uint64_t merged { out[w] | liveIn[successor * words + w] };
+                    changed = changed || merged != out[w];
+                    out[w] = merged;
+                }
+            };
+            if (instruction.op == VMOp::GOTO || instruction.op == VMOp::IF) {
+                merge(labels.at(instruction.arg));
+            }
+            if (instruction.op != VMOp::GOTO && instruction.op != VMOp::RETURN) {
+                merge(i + 1);
+            }
+
+            std::copy(out, out + words, in.begin());
+            if (isLocal(instruction, VMOp::POP)) {
+                erase(in.data(), instruction.arg);
+            } else if (isLocal(instruction, VMOp::PUSH)) {
+                insert(in.data(), instruction.arg);
+            }
+            std::copy(in.begin(), in.end(), &liveIn[i * words]);
+        }
+    }
+
+    entryLive.assign(liveIn.begin(), liveIn.begin() + words);
+    return liveOut;
+}
+
+// greedy coloring in declaration order; each local takes the lowest slot none of its interfering locals holds
+std::vector<int> LocalAllocator::assignSlots(std::size_t words, const LiveSet& liveOut, const LiveSet& liveIn) const {
+    LiveSet interferes(functionVars * words, 0);
+    std::vector<bool> referenced(functionVars, false);
+
+    auto addEdge = [&](int a, int b) {
+        if (a == b) { return; }
+        insert(&interferes[a * words], b);
+        insert(&interferes[b * words], a);
+    };
+
+    for (std::size_t i = 0; i < code.size(); ++i) {
+        if (isLocal(code[i], VMOp::PUSH) || isLocal(code[i], VMOp::POP)) {
+            referenced[code[i].arg] = true;
+        }
+        if (!isLocal(code[i], VMOp::POP)) { continue; }
+
+        for (int other = 0; other < functionVars; ++other) {
+            if (contains(&liveOut[i * words], other)) { addEdge(code[i].arg, other); }
+        }
+    }
+
+    for (int a = 0; a < functionVars; ++a) {
+        if (!contains(liveIn.data(), a)) { continue; }
+        for (int b = a + 1; b < functionVars; ++b) {
+            if (contains(liveIn.data(), b)) { addEdge(a, b); }
+        }
+    }
+
+    std::vector<int> slots(functionVars, NO_SLOT);
+    for (int local = 0; local < functionVars; ++local) {
+        if (!referenced[local]) { continue; }
+
+        std::vector<bool> taken(functionVars, false);
+        for (int other = 0; other < functionVars; ++other) {
+            if (slots[other] != NO_SLOT && contains(&interferes[local * words], other)) { taken[slots[other]] = true; }
+        }
+
+        int slot { 0 };
+        while (taken[slot]) { ++slot; }
+        slots[local] = slot;
+    }
+    return slots;
+}
+
+bool LocalAllocator::isLocal(const VMInstruction& instruction, VMOp op) const {
+    return instruction.op == op && instruction.detail == static_cast<std::uint8_t>(Segment::LOCAL);
+}
+
+}
@@ -0,0 +1,264 @@
+#include "PeepholeOptimizer.hpp"
+
+namespace Compiler {
+
+namespace {
+
+constexpr std::size_t MAX_PATTERN { 5 };
+constexpr int ANY { -1 };
+
+constexpr std::uint16_t opBit(VMOp op) { return static_cast<std::uint16_t>(1u << static_cast<unsigned>(op)); }
+
+constexpr std::uint16_t ALL_OPS { 0xFF };
+
+/**
+ * One element of a pattern: the set of commands it accepts and, optionally, the segment or arithmetic command.
+ */
+struct Match {
+    std::uint16_t ops;
+    int detail;
+};
+
+constexpr Match any(std::uint16_t ops) { return {ops, ANY}; }
+constexpr Match push(Segment segment) { return {opBit(VMOp::PUSH), static_cast<int>(segment)}; }
+constexpr Match pop(Segment segment) { return {opBit(VMOp::POP), static_cast<int>(segment)}; }
+constexpr Match arithmetic(Command command) { return {opBit(VMOp::ARITHMETIC), static_cast<int>(command)}; }
+
+constexpr VMInstruction pushInstruction(Segment segment, int index) {
+    return {VMOp::PUSH, static_cast<std::uint8_t>(segment), index, 0};
+}
+
+constexpr VMInstruction popInstruction(Segment segment, int index) {
+    return {VMOp::POP, static_cast<std::uint8_t>(segment), index, 0};
+}
+
+constexpr VMInstruction arithmeticInstruction(Command command) {
+    return {VMOp::ARITHMETIC, static_cast<std::uint8_t>(command), 0, 0};
+}
+
+constexpr VMInstruction gotoInstruction(int label) {
+    return {VMOp::GOTO, 0, label, 0};
+}
+
+struct Replacement {
+    std::size_t length;
+    std::array<VMInstruction, MAX_PATTERN> code;
+};
+
+/**
+ * A rewrite rule. The pattern matches the last `length` buffered commands; condition, when present, must also
+ * accept them before rewrite replaces them.
+ */
+struct Rule {
+    std::string_view name;
+    std::size_t length;
+    std::array<Match, MAX_PATTERN> pattern;
+    bool (*condition)(const VMInstruction* window);
+    Replacement (*rewrite)(const VMInstruction* window);
+};
+
+bool is(const VMInstruction& instruction, Segment segment, int index) {
+    return instruction.detail == static_cast<std::uint8_t>(segment) && instruction.arg == index;
+}
+
+bool is(const VMInstruction& instruction, Command command) {
+    return instruction.detail == static_cast<std::uint8_t>(command);
+}
+
+/*
+Every rule preserves the values left on the stack and in memory, except for temp 0: the compiler only uses it as
+scratch space, always writing it before reading it within a single statement. Constants pushed by the compiler
+lie in 0..32767, which the comparison rewrites rely on.
+*/
+const std::array<Rule, PeepholeOptimizer::RULE_COUNT> RULES {{
+    // goto L; <anything but a label>  ->  goto L
+    { "unreachable", 2, {any(opBit(VMOp::GOTO) | opBit(VMOp::RETURN)), any(ALL_OPS & ~opBit(VMOp::LABEL))},
+        nullptr,
+        [](const VMInstruction* w) { return Replacement{1, {w[0]}}; } },
+
+    // goto L; label L  ->  label L
+    { "goto-next", 2, {any(opBit(VMOp::GOTO)), any(opBit(VMOp::LABEL))},
+        [](const VMInstruction* w) { return w[0].arg == w[1].arg; },
+        [](const VMInstruction* w) { return Replacement{1, {w[1]}}; } },
+
+    // goto L; label M; label L  ->  label M; label L
+    { "goto-over-label", 3, {any(opBit(VMOp::GOTO)), any(opBit(VMOp::LABEL)), any(opBit(VMOp::LABEL))},
+        [](const VMInstruction* w) { return w[0].arg == w[2].arg; },
+        [](const VMInstruction* w) { return Replacement{2, {w[1], w[2]}}; } },
+
+    // not; not  ->  (nothing)
+    { "double-not", 2, {arithmetic(Command::NOT), arithmetic(Command::NOT)},
+        nullptr,
+        [](const VMInstruction*) { return Replacement{0, {}}; } },
+
+    // neg; neg  ->  (nothing)
+    { "double-neg", 2, {arithmetic(Command::NEG), arithmetic(Command::NEG)},
+        nullptr,
+        [](const VMInstruction*) { return Replacement{0, {}}; } },
+
+    // push constant c; neg; not  ->  push constant c-1, since ~(-c) = c-1
+    { "neg-not", 3, {push(Segment::CONST), arithmetic(Command::NEG), arithmetic(Command::NOT)},
+        [](const VMInstruction* w) { return w[0].arg >= 1; },
+        [](const VMInstruction* w) { return Replacement{1, {pushInstruction(Segment::CONST, w[0].arg - 1)}}; } },
+
+    // push constant c; not; neg  ->  push constant c+1, since -(~c) = c+1
+    { "not-neg", 3, {push(Segment::CONST), arithmetic(Command::NOT), arithmetic(Command::NEG)},
+        [](const VMInstruction* w) { return w[0].arg <= 32766; },
+        [](const VMInstruction* w) { return Replacement{1, {pushInstruction(Segment::CONST, w[0].arg + 1)}}; } },
+
+    // push constant 0; add|sub|or  ->  (nothing)
+    { "identity-zero", 2, {push(Segment::CONST), any(opBit(VMOp::ARITHMETIC))},
+        [](const VMInstruction* w) {
+            return w[0].arg == 0 && (is(w[1], Command::ADD) || is(w[1], Command::SUB) || is(w[1], Command::OR));
+        },
+        [](const VMInstruction*) { return Replacement{0, {}}; } },
+
+    // push constant 0; if-goto L  ->  (nothing)
+    { "branch-never", 2, {push(Segment::CONST), any(opBit(VMOp::IF))},
+        [](const VMInstruction* w) { return w[0].arg == 0; },
+        [](const VMInstruction*) { return Replacement{0, {}}; } },
+
+    // push constant c; if-goto L  ->  goto L, for c != 0
+    { "branch-always", 2, {push(Segment::CONST), any(opBit(VMOp::IF))},
+        [](const VMInstruction* w) { return w[0].arg != 0; },
+        [](const VMInstruction* w) { return Replacement{1, {gotoInstruction(w[1].arg)}}; } },
+
+    // push constant c; not|neg; if-goto L  ->  goto L, when the result is nonzero
+    { "branch-always-unary", 3, {push(Segment::CONST), any(opBit(VMOp::ARITHMETIC)), any(opBit(VMOp::IF))},
+        [](const VMInstruction* w) { return is(w[1], Command::NOT) || (is(w[1], Command::NEG) && w[0].arg != 0); },
+        [](const VMInstruction* w) { return Replacement{1, {gotoInstruction(w[2].arg)}}; } },
+
+    // push constant c; lt; not  ->  push constant c-1; gt, since x >= c is x > c-1
+    { "invert-lt", 3, {push(Segment::CONST), arithmetic(Command::LT), arithmetic(Command::NOT)},
+        [](const VMInstruction* w) { return w[0].arg >= 1; },
+        [](const VMInstruction* w) {
+            return Replacement{2, {pushInstruction(Segment::CONST, w[0].arg - 1), arithmeticInstruction(Command::GT)}};
+        } },
+
+    // push constant c; gt; not  ->  push constant c+1; lt, since x <= c is x < c+1
+    { "invert-gt", 3, {push(Segment::CONST), arithmetic(Command::GT), arithmetic(Command::NOT)},
+        [](const VMInstruction* w) { return w[0].arg <= 32766; },
+        [](const VMInstruction* w) {
+            return Replacement{2, {pushInstruction(Segment::CONST, w[0].arg + 1), arithmeticInstruction(Command::LT)}};
+        } },
+
+    // pop temp 0; push temp 0  ->  (nothing)
+    { "store-reload", 2, {pop(Segment::TEMP), push(Segment::TEMP)},
+        [](const VMInstruction* w) { return w[0].arg == 0 && w[1].arg == 0; },
+        [](const VMInstruction*) { return Replacement{0, {}}; } },
+
+    // push x; pop temp 0; pop pointer 1; push temp 0; pop that 0  ->  pop pointer 1; push x; pop that 0,
+    // when x is not read through or from pointer 1
+    { "array-store", 5, {any(opBit(VMOp::PUSH)), pop(Segment::TEMP), pop(Segment::POINTER), push(Segment::TEMP), pop(Segment::THAT)},
+        [](const VMInstruction* w) {
+            return w[1].arg == 0 && w[2].arg == 1 && w[3].arg == 0 && w[4].arg == 0
+                && w[0].detail != static_cast<std::uint8_t>(Segment::THAT) && !is(w[0], Segment::POINTER, 1);
+        },
+        [](const VMInstruction* w) { return Replacement{3, {w[2], w[0], w[4]}}; } },
+}};
+
+bool matches(const Rule& rule, const VMInstruction* window) {
+    for (std::size_t i = 0; i < rule.length; ++i) {
+        const Match& match { rule.pattern[i] };
+        if (!(match.ops & opBit(window[i].op))) { return false; }
+        if (match.detail != ANY && window[i].detail != match.detail) { return false; }
+    }
+    return rule.condition == nullptr || rule.condition(window);
+}
+
+}
+
+PeepholeOptimizer::PeepholeOptimizer(std::unique_ptr<VMWriter> output) :
+    writer(std::move(output)),
+    hits{} {}
+
+PeepholeOptimizer::~PeepholeOptimizer() {
+    flush();
+}
+
+void PeepholeOptimizer::writePush(const Segment& segment, const int index) {
+    append(VMOp::PUSH, static_cast<std::uint8_t>(segment), index);
+}
+
+void PeepholeOptimizer::writePop(const Segment& segment, const int index) {
+    append(VMOp::POP, static_cast<std::uint8_t>(segment), index);
+}
+
+void PeepholeOptimizer::writeArithmetic(const Command& command) {
+    append(VMOp::ARITHMETIC, static_cast<std::uint8_t>(command), 0);
+}
+
+void PeepholeOptimizer::writeLabel(const int label) {
+    append(VMOp::LABEL, 0, label);
+}
+
+void PeepholeOptimizer::writeGoto(const int label) {
+    append(VMOp::GOTO, 0, label);
+}
+
+void PeepholeOptimizer::writeIf(const int label) {
+    append(VMOp::IF, 0, label);
+}
+
+void PeepholeOptimizer::writeCall(Name name, const int nArgs) {
+    append(VMOp::CALL, 0, nArgs, name);
+}
+
+// a function definition starts a new window; no pattern reaches back into the previous function
+void PeepholeOptimizer::writeFunction(Name name, const int nVars) {
+    flush();
+    writer->writeFunction(name, nVars);
+}
+
+void PeepholeOptimizer::writeReturn() {
+    append(VMOp::RETURN, 0, 0);
+}
+
+void PeepholeOptimizer::finish() {
+    flush();
+    writer->finish();
+}
+
+void PeepholeOptimizer::flush() {
+    for (const VMInstruction& instruction : code) {
+        writer->write(instruction);
+    }
+    code.clear();
+}
+
+const std::array<int, PeepholeOptimizer::RULE_COUNT>& PeepholeOptimizer::ruleHits() const {
+    return hits;
+}
+
+std::string_view PeepholeOptimizer::ruleName(std::size_t rule) {
+    return RULES[rule].name;
+}
+
+void PeepholeOptimizer::append(VMOp op, std::uint8_t detail, int arg, Name name) {
+    code.push_back({op, detail, arg, name});
+    reduce();
+}
+
+// every replacement ends where its match ended, so only patterns ending at the newest command can become new matches
+void PeepholeOptimizer::reduce() {
+    bool changed { true };
+    while (changed) {
+        changed = false;
+        for (std::size_t r = 0; r < RULES.size(); ++r) {
+            const Rule& rule { RULES[r] };
+            if (code.size() < rule.length) { continue; }
+
+            const VMInstruction* window { code.data() + code.size() - rule.length };
+            if (!matches(rule, window)) { continue; }
+
+            Replacement replacement { rule.rewrite(window) };
+            code.resize(code.size() - rule.length);
+            code.insert(code.end(), replacement.code.begin(), replacement.code.begin() + replacement.length);
+            ++hits[r];
+            changed = true;
+            break;
+        }
+    }
+}
+
+}
@@ -0,0 +1,76 @@
+#include "SourceFile.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCEFILE_MMAP 1
+#endif
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+SourceFile::SourceFile(const fs::path& path) :
+    opened(false),
+    mapped(nullptr),
+    size(0) {
+    opened = map(path) || read(path);
+}
+
+SourceFile::~SourceFile() {
+#ifdef SOURCEFILE_MMAP
+    if (mapped) {
+        munmap(const_cast<char*>(mapped), size);
+    }
+#endif
+}
+
+bool SourceFile::isOpen() const {
+    return opened;
+}
+
+std::string_view SourceFile::text() const {
+    return mapped ? std::string_view(mapped, size) : std::string_view(buffer);
+}
+
+bool SourceFile::map(const fs::path& path) {
+#ifdef SOURCEFILE_MMAP
+    int fd { ::open(path.c_str(), O_RDONLY) };
+    if (fd < 0) { return false; }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        // empty files cannot be mapped; let the buffered path handle them
+        ::close(fd);
+        return false;
+    }
+
+    void* addr { mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0) };
+    ::close(fd);
+    if (addr == MAP_FAILED) { return false; }
+
+    madvise(addr, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+    mapped = static_cast<const char*>(addr);
+    size = static_cast<std::size_t>(info.st_size);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SourceFile::read(const fs::path& path) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) { return false; }
+
+    std::stringstream contents;
+    contents << infile.rdbuf();
+    buffer = contents.str();
+    return true;
+}
+
+}
@@ -0,0 +1,186 @@
+#include "SubexpressionEliminator.hpp"
+#include "CompilerResources.hpp"
+
+#include <algorithm>
+
+namespace Compiler {
+
+SubexpressionEliminator::SubexpressionEliminator(AST& tree) :
+    ast(tree),
+    subroutine(nullptr),
+    eliminated(0) {}
+
+void SubexpressionEliminator::run() {
+    for (SubroutineDec& dec : ast.subroutines) {
+        subroutine = &dec;
+        visitBlock(dec.body);
+    }
+    subroutine = nullptr;
+}
+
+const std::unordered_map<NodeId, int>& SubexpressionEliminator::getCachedValues() const {
+    return cachedValues;
+}
+
+int SubexpressionEliminator::getEliminated() const {
+    return eliminated;
+}
+
+// each statement numbers its own expressions: the index of an array target, then the value of a let
+void SubexpressionEliminator::visitBlock(NodeId block) {
+    for (NodeId statement = ast[block].firstChild; statement != NO_NODE; statement = ast[statement].nextSibling) {
+        available.clear();
+
+        switch (ast[statement].kind) {
+            case NodeKind::LET: {
+                NodeId target { ast.child(statement, 0) };
+                if (ast[target].kind == NodeKind::ARRAY_ELEM) {
+                    number(ast.child(target, 1));
+                }
+                number(ast.child(statement, 1));
+                break;
+            }
+            case NodeKind::IF: {
+                number(ast.child(statement, 0));
+                visitBlock(ast.child(statement, 1));
+                NodeId elseBlock { ast.child(statement, 2) };
+                if (elseBlock != NO_NODE) {
+                    visitBlock(elseBlock);
+                }
+                break;
+            }
+            case NodeKind::WHILE:
+                number(ast.child(statement, 0));
+                visitBlock(ast.child(statement, 1));
+                break;
+            case NodeKind::DO:
+                number(ast.child(statement, 0));
+                break;
+            case NodeKind::RETURN:
+                if (ast[statement].firstChild != NO_NODE) {
+                    number(ast[statement].firstChild);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// an expression becomes available once it has been evaluated, so none of its own subexpressions can reuse it
+void SubexpressionEliminator::number(NodeId node) {
+    bool candidate { isCandidate(node) };
+    std::uint64_t nodeHash { candidate ? hash(node) : 0 };
+
+    if (candidate) {
+        for (const Value& value : available) {
+            if (value.hash == nodeHash && equal(value.node, node)) {
+                reuse(node, value.node);
+                return;
+            }
+        }
+    }
+
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        number(child);
+    }
+
+    if (ast[node].kind == NodeKind::CALL || ast[node].kind == NodeKind::STRING_CONST) {
+        available.erase(std::remove_if(available.begin(), available.end(), [](const Value& value) { return value.readsMemory; }),
+                        available.end());
+    }
+
+    if (candidate) {
+        available.push_back({node, nodeHash, readsMemory(node)});
+    }
+}
+
+// the repeat is rewritten in place into a read of the local, so its parent's links and next sibling stay valid
+void SubexpressionEliminator::reuse(NodeId node, NodeId first) {
+    auto [cached, added] { cachedValues.emplace(first, subroutine->nLocals) };
+    if (added) {
+        ++subroutine->nLocals;
+    }
+
+    ast[node].kind = NodeKind::VAR;
+    ast[node].op = static_cast<std::uint8_t>(Segment::LOCAL);
+    ast[node].value = static_cast<std::uint32_t>(cached->second);
+    ast[node].firstChild = NO_NODE;
+
+    ++eliminated;
+}
+
+bool SubexpressionEliminator::isCandidate(NodeId node) const {
+    NodeKind kind { ast[node].kind };
+    if (kind != NodeKind::UNARY && kind != NodeKind::BINARY && kind != NodeKind::ARRAY_ELEM) { return false; }
+    return isPure(node) && cost(node) >= MIN_COST;
+}
+
+// Math.multiply and Math.divide change nothing the program can read, so * and / count as pure
+bool SubexpressionEliminator::isPure(NodeId node) const {
+    if (ast[node].kind == NodeKind::CALL || ast[node].kind == NodeKind::STRING_CONST) { return false; }
+
+    for (NodeId child = ast[node].firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        if (!isPure(child)) { return false; }
+    }
+    return true;
+}
+
+bool SubexpressionEliminator::readsMemory(NodeId node) const {
+    const Node& n { ast[node] };
+    if (n.kind == NodeKind::ARRAY_ELEM) { return true; }
+    if (n.kind == NodeKind::VAR && n.segment() != Segment::LOCAL && n.segment() != Segment::ARG) { return true; }
+
+    for (NodeId child = n.firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        if (readsMemory(child)) { return true; }
+    }
+    return false;
+}
+
+// rough number of VM commands the expression compiles to; * and / stand for their calls
+int SubexpressionEliminator::cost(NodeId node) const {
+    const Node& n { ast[node] };
+    int total { 0 };
+    switch (n.kind) {
+        case NodeKind::INT_CONST:
+            return static_cast<std::int16_t>(n.value) < 0 ? 2 : 1;
+        case NodeKind::KEYWORD_CONST:
+            return n.keyword() == Keyword::TRUE ? 2 : 1;
+        case NodeKind::ARRAY_ELEM:
+            total = 3;
+            break;
+        case NodeKind::BINARY:
+            total = n.symbol() == Symbol::STAR || n.symbol() == Symbol::SLASH ? 10 : 1;
+            break;
+        default:
+            total = 1;
+            break;
+    }
+
+    for (NodeId child = n.firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        total += cost(child);
+    }
+    return total;
+}
+
+std::uint64_t SubexpressionEliminator::hash(NodeId node) const {
+    const Node& n { ast[node] };
+    std::uint64_t h { static_cast<std::uint64_t>(n.kind) << 40 ^ static_cast<std::uint64_t>(n.op) << 32 ^ n.value };
+    for (NodeId child = n.firstChild; child != NO_NODE; child = ast[child].nextSibling) {
+        h = h * 1099511628211u ^ hash(child);
+    }
+    return h;
+}
+
+bool SubexpressionEliminator::equal(NodeId a, NodeId b) const {
+    if (ast[a].kind != ast[b].kind || ast[a].op != ast[b].op || ast[a].value != ast[b].value) { return false; }
+
+    NodeId x { ast[a].firstChild };
+    NodeId y { ast[b].firstChild };
+    for (; x != NO_NODE && y != NO_NODE; x = ast[x].nextSibling, y = ast[y].nextSibling) {
+        if (!equal(x, y)) { return false; }
+    }
+    return x == y;
+}
+
+}
@@ -1,25 +1,24 @@
 #include "SymbolTable.hpp"
 #include "CompilerResources.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace Compiler {
 
 namespace fs = std::filesystem;
 
-std::ostream& operator<<(std::ostream& os, const SymbolTable::Entry& entry) {
-    os << entry.type << ' ' << entry.segment << ' ' << entry.index;
-    return os;
-}
-
-SymbolTable::SymbolTable(std::ofstream* const debugFilePath) :
-    debugFile(debugFilePath),
+SymbolTable::SymbolTable(const InternPool& namePool, std::ostream* const debugFilePath) :
+    pool(namePool),
     counters {
         {Segment::THIS, 0},
         {Segment::STATIC, 0},
         {Segment::ARG, 0},
         {Segment::LOCAL, 0},
-    } {}
+    },
+    debugFile(debugFilePath) {}
 
-bool SymbolTable::contains(const std::string& name) const {
+bool SymbolTable::contains(Name name) const {
     return data.find(name) != data.end();
 }
 
@@ -30,14 +29,14 @@ void SymbolTable::reset() {
     }
 }
 
-void SymbolTable::define(const std::string& name, const std::string& type, const Segment& segment) {
+void SymbolTable::define(Name name, Name type, const Segment& segment) {
     Segment internalSegment { segment == Segment::FIELD ? Segment::THIS : segment };
     SymbolTable::Entry entry { type, internalSegment, counters.at(internalSegment)++ };
     data[name] = entry;
 }
 
-void SymbolTable::defineThisObject(const std::string& type) {
-    define(+Keyword::THIS, type, Segment::ARG);
+void SymbolTable::defineThisObject(Name type) {
+    define(BuiltinName::THIS, type, Segment::ARG);
 }
 
 int SymbolTable::varCount(const Segment& segment) const {
@@ -45,27 +44,38 @@ int SymbolTable::varCount(const Segment& segment) const {
     return counters.at(internalSegment);
 }
 
-const SymbolTable::Entry* SymbolTable::getEntry(const std::string& name) const {
+const SymbolTable::Entry* SymbolTable::getEntry(Name name) const {
     return &data.at(name);
 }
 
-std::string SymbolTable::typeOf(const std::string& name) const {
+Name SymbolTable::typeOf(Name name) const {
     return getEntry(name)->type;
 }
 
-Segment SymbolTable::segmentOf(const std::string& name) const {
+Segment SymbolTable::segmentOf(Name name) const {
     return getEntry(name)->segment;
 }
 
-int SymbolTable::indexOf(const std::string& name) const {
+int SymbolTable::indexOf(Name name) const {
     return getEntry(name)->index;
 }
 
-void SymbolTable::dumpTable(const std::string& tag) {
+void SymbolTable::dumpTable(Name scope, std::string_view kind) {
     if (debugFile) {
-        *debugFile << tag << "SymbolTable\n";
-        for (const std::pair<const std::string, SymbolTable::Entry>& pair : data) {
-            *debugFile << pair.first << ": " << pair.second << '\n';
+        *debugFile << pool.str(scope) << ' ' << kind << "SymbolTable\n";
+        // list entries in declaration order so the dump does not depend on handle values or hashing
+        std::vector<const std::pair<const Name, SymbolTable::Entry>*> entries;
+        entries.reserve(data.size());
+        for (const std::pair<const Name, SymbolTable::Entry>& pair : data) {
+            entries.push_back(&pair);
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+            return std::pair(a->second.segment, a->second.index) < std::pair(b->second.segment, b->second.index);
+        });
+
+        for (const std::pair<const Name, SymbolTable::Entry>* pair : entries) {
+            const SymbolTable::Entry& entry { pair->second };
+            *debugFile << pool.str(pair->first) << ": " << pool.str(entry.type) << ' ' << entry.segment << ' ' << entry.index << '\n';
         }
         *debugFile << "------\n";
     }
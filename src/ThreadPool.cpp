@@ -0,0 +1,99 @@
+#include "ThreadPool.hpp"
+
+namespace Compiler {
+
+ThreadPool::ThreadPool(std::size_t nThreads) :
+    queued(0),
+    unfinished(0),
+    nextQueue(0),
+    stopping(false) {
+    if (nThreads == 0) { nThreads = 1; }
+
+    for (std::size_t i = 0; i < nThreads; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (std::size_t i = 0; i < nThreads; ++i) {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    std::size_t target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        target = nextQueue++ % queues.size();
+        ++queued;
+        ++unfinished;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+bool ThreadPool::popOwn(std::size_t self, std::function<void()>& task) {
+    WorkQueue& queue { *queues[self] };
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) { return false; }
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(std::size_t self, std::function<void()>& task) {
+    for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& victim { *queues[(self + offset) % queues.size()] };
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) { continue; }
+
+        task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(std::size_t self) {
+    std::function<void()> task;
+
+    while (true) {
+        if (popOwn(self, task) || steal(self, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                --queued;
+            }
+            task();
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--unfinished == 0) { allDone.notify_all(); }
+            continue;
+        }
+
+        // a task may be queued between the failed pop and this wait; queued is only changed under stateMutex
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) { return; }
+    }
+}
+
+}
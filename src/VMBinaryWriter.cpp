@@ -0,0 +1,171 @@
+#include "VMBinaryWriter.hpp"
+#include "CompilerResources.hpp"
+
+#include <fstream>
+#include <string>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+EncodingError::EncodingError(const std::string& reason) :
+    JackCompilerError("Cannot encode in .vmb: " + reason + '\n') {}
+
+static void put16(std::string& out, std::uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+static void put32(std::string& out, std::uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out += static_cast<char>((value >> shift) & 0xFF);
+    }
+}
+
+VMBinaryWriter::VMBinaryWriter(const fs::path& outfilePath, const InternPool& namePool) :
+    outfile(outfilePath),
+    pool(namePool) {}
+
+void VMBinaryWriter::add(VMBOpcode opcode, std::uint8_t segment, int index, std::uint32_t operand) {
+    if (index < 0 || index > UINT16_MAX) {
+        throw EncodingError("index " + std::to_string(index) + " does not fit in 16 bits");
+    }
+    code.push_back(Instruction { opcode, segment, static_cast<std::uint16_t>(index), operand });
+}
+
+std::uint32_t VMBinaryWriter::addString(std::string_view str) {
+    std::uint32_t id { static_cast<std::uint32_t>(stringOffsets.size()) };
+    stringOffsets.push_back(static_cast<std::uint32_t>(stringData.size()));
+    stringData.append(str);
+    stringData += '\0';
+    return id;
+}
+
+std::uint32_t VMBinaryWriter::nameString(Name name) {
+    auto it { nameStrings.find(name) };
+    if (it != nameStrings.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id { addString(pool.str(name)) };
+    nameStrings.emplace(name, id);
+    return id;
+}
+
+// label numbers restart in every function, so each "L<n>" string is stored once and shared
+std::uint32_t VMBinaryWriter::labelString(int label) {
+    if (static_cast<std::size_t>(label) >= labelStrings.size()) {
+        labelStrings.resize(label + 1, NO_TARGET);
+    }
+    if (labelStrings[label] == NO_TARGET) {
+        labelStrings[label] = addString("L" + std::to_string(label));
+    }
+    return labelStrings[label];
+}
+
+void VMBinaryWriter::writePush(const Segment& segment, const int index) {
+    add(VMBOpcode::PUSH, static_cast<std::uint8_t>(segment), index, 0);
+}
+
+void VMBinaryWriter::writePop(const Segment& segment, const int index) {
+    add(VMBOpcode::POP, static_cast<std::uint8_t>(segment), index, 0);
+}
+
+void VMBinaryWriter::writeArithmetic(const Command& command) {
+    add(static_cast<VMBOpcode>(static_cast<int>(VMBOpcode::ADD) + static_cast<int>(command)), 0, 0, 0);
+}
+
+void VMBinaryWriter::writeLabel(const int label) {
+    if (static_cast<std::size_t>(label) >= labelTargets.size()) {
+        labelTargets.resize(label + 1, NO_TARGET);
+    }
+    labelTargets[label] = static_cast<std::uint32_t>(code.size());
+
+    add(VMBOpcode::LABEL, 0, 0, labelString(label));
+}
+
+// jump operands hold the label number until resolveLabels replaces it with the target instruction index
+void VMBinaryWriter::writeGoto(const int label) {
+    add(VMBOpcode::GOTO, 0, 0, static_cast<std::uint32_t>(label));
+}
+
+void VMBinaryWriter::writeIf(const int label) {
+    add(VMBOpcode::IF_GOTO, 0, 0, static_cast<std::uint32_t>(label));
+}
+
+void VMBinaryWriter::writeCall(Name name, const int nArgs) {
+    add(VMBOpcode::CALL, 0, nArgs, nameString(name));
+}
+
+void VMBinaryWriter::writeFunction(Name name, const int nVars) {
+    resolveLabels();
+
+    std::uint32_t nameId { nameString(name) };
+    functions.push_back(Function { nameId, static_cast<std::uint32_t>(nVars), static_cast<std::uint32_t>(code.size()) });
+    add(VMBOpcode::FUNCTION, 0, nVars, nameId);
+}
+
+void VMBinaryWriter::writeReturn() {
+    add(VMBOpcode::RETURN, 0, 0, 0);
+}
+
+void VMBinaryWriter::finish() {
+    resolveLabels();
+    writeFile();
+}
+
+// jump operands hold label numbers until the end of their function, since label numbers may repeat across functions
+void VMBinaryWriter::resolveLabels() {
+    for (std::size_t i = functionStart; i < code.size(); ++i) {
+        Instruction& instruction { code[i] };
+        if (instruction.opcode != VMBOpcode::GOTO && instruction.opcode != VMBOpcode::IF_GOTO) { continue; }
+
+        std::uint32_t label { instruction.operand };
+        if (label >= labelTargets.size() || labelTargets[label] == NO_TARGET) {
+            throw EncodingError("jump to undefined label L" + std::to_string(label));
+        }
+        instruction.operand = labelTargets[label];
+    }
+
+    labelTargets.clear();
+    functionStart = code.size();
+}
+
+void VMBinaryWriter::writeFile() {
+    while (stringData.size() % 4 != 0) {
+        stringData += '\0';
+    }
+
+    std::string out;
+    out.reserve(24 + functions.size() * 12 + stringOffsets.size() * 4 + stringData.size() + code.size() * 8);
+
+    put32(out, MAGIC);
+    put32(out, VERSION);
+    put32(out, static_cast<std::uint32_t>(functions.size()));
+    put32(out, static_cast<std::uint32_t>(stringOffsets.size()));
+    put32(out, static_cast<std::uint32_t>(stringData.size()));
+    put32(out, static_cast<std::uint32_t>(code.size()));
+
+    for (const Function& function : functions) {
+        put32(out, function.name);
+        put32(out, function.nLocals);
+        put32(out, function.firstInstruction);
+    }
+
+    for (std::uint32_t offset : stringOffsets) {
+        put32(out, offset);
+    }
+    out += stringData;
+
+    for (const Instruction& instruction : code) {
+        out += static_cast<char>(instruction.opcode);
+        out += static_cast<char>(instruction.segment);
+        put16(out, instruction.index);
+        put32(out, instruction.operand);
+    }
+
+    std::ofstream file(outfile, std::ios::binary);
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+}
+
+}
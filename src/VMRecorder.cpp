@@ -0,0 +1,56 @@
+#include "VMRecorder.hpp"
+
+namespace Compiler {
+
+VMRecorder::VMRecorder(std::vector<VMFunction>& output) :
+    functions(output) {}
+
+void VMRecorder::writePush(const Segment& segment, const int index) {
+    append({VMOp::PUSH, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void VMRecorder::writePop(const Segment& segment, const int index) {
+    append({VMOp::POP, static_cast<std::uint8_t>(segment), index, 0});
+}
+
+void VMRecorder::writeArithmetic(const Command& command) {
+    append({VMOp::ARITHMETIC, static_cast<std::uint8_t>(command), 0, 0});
+}
+
+void VMRecorder::writeLabel(const int label) {
+    append({VMOp::LABEL, 0, label, 0});
+}
+
+void VMRecorder::writeGoto(const int label) {
+    append({VMOp::GOTO, 0, label, 0});
+}
+
+void VMRecorder::writeIf(const int label) {
+    append({VMOp::IF, 0, label, 0});
+}
+
+void VMRecorder::writeCall(Name name, const int nArgs) {
+    append({VMOp::CALL, 0, nArgs, name});
+}
+
+void VMRecorder::writeFunction(Name name, const int nVars) {
+    functions.push_back(VMFunction { name, nVars, {} });
+}
+
+void VMRecorder::writeReturn() {
+    append({VMOp::RETURN, 0, 0, 0});
+}
+
+void VMRecorder::replay(const VMFunction& function, VMWriter& writer) {
+    writer.writeFunction(function.name, function.nVars);
+    for (const VMInstruction& instruction : function.code) {
+        writer.write(instruction);
+    }
+}
+
+// the compiler always defines a function before writing its commands
+void VMRecorder::append(const VMInstruction& instruction) {
+    functions.back().code.push_back(instruction);
+}
+
+}
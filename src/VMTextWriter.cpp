@@ -0,0 +1,130 @@
+#include "VMTextWriter.hpp"
+#include "CompilerResources.hpp"
+
+#include <array>
+#include <charconv>
+
+namespace Compiler {
+
+namespace fs = std::filesystem;
+
+// per-segment "\tpush <segment> " and "\tpop <segment> " prefixes, and per-command "\t<command>\n" lines
+static std::array<std::string, std::size(SEGMENT_STRINGS)> buildSegmentPrefixes(std::string_view command) {
+    std::array<std::string, std::size(SEGMENT_STRINGS)> prefixes;
+    for (std::size_t i = 0; i < prefixes.size(); ++i) {
+        prefixes[i] = std::string(command) + std::string(SEGMENT_STRINGS[i]) + ' ';
+    }
+    return prefixes;
+}
+
+static std::array<std::string, std::size(COMMAND_STRINGS)> buildCommandLines() {
+    std::array<std::string, std::size(COMMAND_STRINGS)> lines;
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        lines[i] = '\t' + std::string(COMMAND_STRINGS[i]) + '\n';
+    }
+    return lines;
+}
+
+static const std::array<std::string, std::size(SEGMENT_STRINGS)> PUSH_PREFIXES { buildSegmentPrefixes("\tpush ") };
+static const std::array<std::string, std::size(SEGMENT_STRINGS)> POP_PREFIXES { buildSegmentPrefixes("\tpop ") };
+static const std::array<std::string, std::size(COMMAND_STRINGS)> COMMAND_LINES { buildCommandLines() };
+
+VMTextWriter::VMTextWriter(const fs::path& outfilePath, const InternPool& namePool) :
+    outfile(outfilePath, std::ios::binary),
+    pool(namePool) {
+    buffer.reserve(BUFFER_SIZE);
+}
+
+VMTextWriter::~VMTextWriter() {
+    flush();
+}
+
+void VMTextWriter::flush() {
+    outfile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+// flushes first if the next command might not fit, so the buffer never reallocates for ordinary commands
+void VMTextWriter::ensureSpace(std::size_t size) {
+    if (buffer.size() + size > buffer.capacity()) {
+        flush();
+        if (size > buffer.capacity()) { buffer.reserve(size); }
+    }
+}
+
+void VMTextWriter::append(std::string_view str) {
+    buffer.append(str);
+}
+
+void VMTextWriter::appendInt(int value) {
+    char digits[16];
+    auto [end, error] { std::to_chars(digits, digits + sizeof(digits), value) };
+    buffer.append(digits, end);
+}
+
+void VMTextWriter::writePush(const Segment& segment, const int index) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append(PUSH_PREFIXES[static_cast<std::size_t>(segment)]);
+    appendInt(index);
+    buffer += '\n';
+}
+
+void VMTextWriter::writePop(const Segment& segment, const int index) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append(POP_PREFIXES[static_cast<std::size_t>(segment)]);
+    appendInt(index);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeArithmetic(const Command& command) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append(COMMAND_LINES[static_cast<std::size_t>(command)]);
+}
+
+void VMTextWriter::writeLabel(const int label) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append("label L");
+    appendInt(label);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeGoto(const int label) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append("\tgoto L");
+    appendInt(label);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeIf(const int label) {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append("\tif-goto L");
+    appendInt(label);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeCall(Name name, const int nArgs) {
+    std::string_view str { pool.str(name) };
+    ensureSpace(MAX_COMMAND_SIZE + str.size());
+    append("\tcall ");
+    append(str);
+    buffer += ' ';
+    appendInt(nArgs);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeFunction(Name name, const int nVars) {
+    std::string_view str { pool.str(name) };
+    ensureSpace(MAX_COMMAND_SIZE + str.size());
+    append("function ");
+    append(str);
+    buffer += ' ';
+    appendInt(nVars);
+    buffer += '\n';
+}
+
+void VMTextWriter::writeReturn() {
+    ensureSpace(MAX_COMMAND_SIZE);
+    append("\treturn\n");
+}
+
+}
@@ -1,44 +1,39 @@
 #include "VMWriter.hpp"
-#include "CompilerResources.hpp"
+#include "VMBinaryWriter.hpp"
+#include "VMTextWriter.hpp"
 
 namespace Compiler {
 
 namespace fs = std::filesystem;
 
-void VMWriter::writePush(const Segment& segment, const int index) {
-    outfile << "\tpush " << segment << ' ' << index << '\n';
-}
-
-void VMWriter::writePop(const Segment& segment, const int index) {
-    outfile << "\tpop " << segment << ' ' << index << '\n';
-}
-
-void VMWriter::writeArithmetic(const Command& command) {
-    outfile << '\t' << command << '\n';
-}
-
-void VMWriter::writeLabel(const std::string& label) {
-    outfile << "label " << label << '\n';
-}
-
-void VMWriter::writeGoto(const std::string& label) {
-    outfile << "\tgoto " << label << '\n';
-}
-
-void VMWriter::writeIf(const std::string& label) {
-    outfile << "\tif-goto " << label << '\n';
-}
-
-void VMWriter::writeCall(const std::string& name, const int nArgs) {
-    outfile << "\tcall " << name << ' ' << nArgs << '\n';
-}
-
-void VMWriter::writeFunction(const std::string& name, const int nVars) {
-    outfile << "function " << name << ' ' << nVars << '\n';
-}
-
-void VMWriter::writeReturn() {
-    outfile << "\treturn\n";
+// whole-program formats are written through HackWriter, which collects each class in memory instead of a file
+std::unique_ptr<VMWriter> VMWriter::create(const fs::path& outfilePath, const InternPool& namePool, OutputFormat format) {
+    switch (format) {
+        case OutputFormat::VMB: return std::make_unique<VMBinaryWriter>(outfilePath, namePool);
+        default:                return std::make_unique<VMTextWriter>(outfilePath, namePool);
+    }
+}
+
+const char* VMWriter::extension(OutputFormat format) {
+    switch (format) {
+        case OutputFormat::VMB: return ".vmb";
+        case OutputFormat::ASM: return ".asm";
+        case OutputFormat::HACK: return ".hack";
+        default:                return ".vm";
+    }
+}
+
+void VMWriter::write(const VMInstruction& instruction) {
+    switch (instruction.op) {
+        case VMOp::PUSH:       writePush(static_cast<Segment>(instruction.detail), instruction.arg); break;
+        case VMOp::POP:        writePop(static_cast<Segment>(instruction.detail), instruction.arg); break;
+        case VMOp::ARITHMETIC: writeArithmetic(static_cast<Command>(instruction.detail)); break;
+        case VMOp::LABEL:      writeLabel(instruction.arg); break;
+        case VMOp::GOTO:       writeGoto(instruction.arg); break;
+        case VMOp::IF:         writeIf(instruction.arg); break;
+        case VMOp::CALL:       writeCall(instruction.name, instruction.arg); break;
+        case VMOp::RETURN:     writeReturn(); break;
+    }
 }
 
 void VMWriter::writeConstant(const int index) {
@@ -1,25 +1,26 @@
+#include "CompilerOptions.hpp"
 #include "JackCompiler.hpp"
 #include "utils.hpp"
 
 #include <string>
 
 int main(int argc, char* argv[]) {
-    if (!Compiler::isValidArguments(argc, argv)) {
+    Compiler::CompilerOptions options;
+    if (!Compiler::parseArguments(argc, argv, options)) {
         Compiler::displayUsage();
         exit(1);
     }
 
     std::string sourceFile { argv[1] };
-    bool debugMode { argc == 3 };
 
     Compiler::JackCompiler compiler;
-    compiler.compile(sourceFile, debugMode);
+    std::size_t nFailed { compiler.compile(sourceFile, options) };
 
-    return 0;
+    return nFailed == 0 ? 0 : 2;
 }
 
 /**
  * Exit codes:
  * 1: Incorrect argv usage
- * 2: File not opened
+ * 2: At least one file not opened or not compiled
  */
@@ -1,34 +1,90 @@
 #include "utils.hpp"
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
-#include <regex>
+#include <string_view>
+#include <thread>
 
 namespace Compiler {
 
-bool isValidArguments(const int argc, const char* const argv[]) {
-    return argc == 2 || (argc == 3 && std::string(argv[2]) == "-d");
-}
+// accepts a positive job count, or 0 for one job per hardware thread
+static bool parseJobs(std::string_view arg, unsigned& jobs) {
+    unsigned value { 0 };
+    auto [end, error] { std::from_chars(arg.data(), arg.data() + arg.size(), value) };
+    if (arg.empty() || error != std::errc() || end != arg.data() + arg.size()) {
+        return false;
+    }
 
-void displayUsage() {
-    std::cerr << "Usage: bin/JackCompiler <dirname OR filename.vm> [-d]\n";
-    std::cerr << "   -d: Enables symbol table debug file\n";
+    jobs = value == 0 ? std::max(1u, std::thread::hardware_concurrency()) : value;
+    return true;
 }
 
-void removeComments(std::string& text) {
-    std::regex singleLinePattern("//.*");
-    std::regex multiLinePattern(R"(/\*[\s\S]*?\*/)");
+// the limit counts the commands of a function's body, excluding its final return
+static bool parseInlineLimit(std::string_view arg, unsigned& limit) {
+    unsigned value { 0 };
+    auto [end, error] { std::from_chars(arg.data(), arg.data() + arg.size(), value) };
+    if (arg.empty() || error != std::errc() || end != arg.data() + arg.size() || value == 0) {
+        return false;
+    }
 
-    text = std::regex_replace(text, singleLinePattern, "");
-    text = std::regex_replace(text, multiLinePattern, "");
+    limit = value;
+    return true;
 }
 
-bool strIsDigit(const std::string& str) {
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (!isdigit(str[i])) {
+bool parseArguments(const int argc, const char* const argv[], CompilerOptions& options) {
+    if (argc < 2) { return false; }
+
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg { argv[i] };
+
+        if (arg == "-d") {
+            options.debugMode = true;
+        } else if (arg == "-O") {
+            options.optimize = true;
+        } else if (arg == "--pool-strings") {
+            options.poolStrings = true;
+        } else if (arg == "--prune") {
+            options.prune = true;
+        } else if (arg == "--inline") {
+            options.inlineLimit = DEFAULT_INLINE_LIMIT;
+        } else if (arg.substr(0, 9) == "--inline=") {
+            if (!parseInlineLimit(arg.substr(9), options.inlineLimit)) { return false; }
+        } else if (arg == "--stats") {
+            options.reportStats = true;
+        } else if (arg == "--cache") {
+            options.useCache = true;
+        } else if (arg == "--emit=vm") {
+            options.format = OutputFormat::VM;
+        } else if (arg == "--emit=vmb") {
+            options.format = OutputFormat::VMB;
+        } else if (arg == "--emit=asm") {
+            options.format = OutputFormat::ASM;
+        } else if (arg == "--emit=hack") {
+            options.format = OutputFormat::HACK;
+        } else if (arg == "-j") {
+            if (++i == argc || !parseJobs(argv[i], options.jobs)) { return false; }
+        } else if (arg.substr(0, 2) == "-j") {
+            if (!parseJobs(arg.substr(2), options.jobs)) { return false; }
+        } else {
             return false;
         }
     }
     return true;
 }
 
+void displayUsage() {
+    std::cerr << "Usage: bin/JackCompiler <dirname OR filename.jack> [-d] [-O] [--stats] [--pool-strings] [--prune] [--inline[=N]] [-j N] [--cache] [--emit=vm|vmb|asm|hack]\n";
+    std::cerr << "   -d: Enables symbol table debug file\n";
+    std::cerr << "   -O: Optimizes the generated code\n";
+    std::cerr << "   --stats: Prints the optimizations applied to each file\n";
+    std::cerr << "   --pool-strings: Builds each string literal once per class; literals must not be modified or disposed\n";
+    std::cerr << "   --prune: Drops functions unreachable from Sys.init and Main.main; no file is written unless all compile\n";
+    std::cerr << "   --inline[=N]: Inlines leaf functions of up to N commands (default " << DEFAULT_INLINE_LIMIT << ") at their call sites\n";
+    std::cerr << "   -j N: Compiles up to N files in parallel (0 = one per hardware thread)\n";
+    std::cerr << "   --cache: Skips files unchanged since the last build (always recompiles with -d; not used with asm/hack, --prune or --inline)\n";
+    std::cerr << "   --emit=vm|vmb: Writes textual VM commands (default) or binary VM bytecode for each class\n";
+    std::cerr << "   --emit=asm|hack: Writes the whole program as Hack assembly or Hack machine code\n";
+}
+
 }
@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr long MAX_STEPS { 50000000 };
+
+/*
+Emulates the Hack CPU on an assembled program: A, D and PC registers, a 32K-word RAM, and the program in ROM. The
+program has halted once a jump returns the CPU to a state it was in before, with the same registers and RAM, as
+`while (true) {}` does. RAM is compared by a hash that is updated on every write.
+*/
+class Cpu {
+public:
+    explicit Cpu(std::vector<std::uint16_t> program) :
+        rom(std::move(program)),
+        ram(32768, 0),
+        lastJumps(rom.size()) {}
+
+    /**
+     * Runs the program until it halts. Returns false if it runs off the end of ROM or exceeds the step limit.
+     */
+    bool run() {
+        for (long steps = 0; steps < MAX_STEPS; ++steps) {
+            if (pc >= rom.size()) { return false; }
+
+            std::uint16_t instruction { rom[pc] };
+            if ((instruction & 0x8000) == 0) {
+                a = instruction;
+                ++pc;
+                continue;
+            }
+
+            std::uint16_t address { a };
+            std::uint16_t y { (instruction & 0x1000) != 0 ? ram.at(address & 0x7fff) : a };
+            std::uint16_t out { compute((instruction >> 6) & 0x3f, y) };
+
+            if ((instruction & 0x08) != 0) {
+                std::uint16_t& word { ram.at(address & 0x7fff) };
+                ramHash ^= mix(address & 0x7fff, word) ^ mix(address & 0x7fff, out);
+                word = out;
+            }
+            if ((instruction & 0x20) != 0) { a = out; }
+            if ((instruction & 0x10) != 0) { d = out; }
+
+            std::int16_t value { static_cast<std::int16_t>(out) };
+            bool jump { ((instruction & 0x04) != 0 && value < 0) || ((instruction & 0x02) != 0 && value == 0) || ((instruction & 0x01) != 0 && value > 0) };
+            if (!jump) {
+                ++pc;
+                continue;
+            }
+
+            pc = address;
+            if (pc >= rom.size()) { return false; }
+
+            JumpState state { a, d, ramHash, true };
+            if (lastJumps[pc] == state) { return true; }
+            lastJumps[pc] = state;
+        }
+        return false;
+    }
+
+    std::int16_t peek(int address) const {
+        return static_cast<std::int16_t>(ram.at(address));
+    }
+
+private:
+    struct JumpState {
+        std::uint16_t a;
+        std::uint16_t d;
+        std::uint64_t ramHash;
+        bool seen;
+
+        bool operator==(const JumpState& other) const {
+            return seen && other.seen && a == other.a && d == other.d && ramHash == other.ramHash;
+        }
+    };
+
+    std::vector<std::uint16_t> rom;
+    std::vector<std::uint16_t> ram;
+    std::vector<JumpState> lastJumps;
+    std::uint64_t ramHash { 0 };
+    std::uint16_t a { 0 };
+    std::uint16_t d { 0 };
+    std::size_t pc { 0 };
+
+    // splitmix64 of an address and the word stored there
+    static std::uint64_t mix(std::uint64_t address, std::uint64_t word) {
+        std::uint64_t z { (address << 16 | word) + 0x9e3779b97f4a7c15 };
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    std::uint16_t compute(int comp, std::uint16_t y) const {
+        switch (comp) {
+            case 0x2a: return 0;
+            case 0x3f: return 1;
+            case 0x3a: return 0xffff;
+            case 0x0c: return d;
+            case 0x30: return y;
+            case 0x0d: return ~d;
+            case 0x31: return ~y;
+            case 0x0f: return -d;
+            case 0x33: return -y;
+            case 0x1f: return d + 1;
+            case 0x37: return y + 1;
+            case 0x0e: return d - 1;
+            case 0x32: return y - 1;
+            case 0x02: return d + y;
+            case 0x13: return d - y;
+            case 0x07: return y - d;
+            case 0x00: return d & y;
+            case 0x15: return d | y;
+            default: throw std::runtime_error("bad comp field at " + std::to_string(pc));
+        }
+    }
+};
+
+std::vector<std::uint16_t> readProgram(const fs::path& path) {
+    std::ifstream file(path);
+    if (!file) { throw std::runtime_error("cannot open " + path.string()); }
+
+    std::vector<std::uint16_t> program;
+    std::string word;
+    while (file >> word) {
+        program.push_back(static_cast<std::uint16_t>(std::stoul(word, nullptr, 2)));
+    }
+    return program;
+}
+
+// a .cmp file in the nand2tetris layout: a row of |RAM[n]| headers, then a row of the expected values
+std::vector<std::pair<int, int>> readExpected(const fs::path& path) {
+    std::ifstream file(path);
+    std::string header;
+    std::string values;
+    if (!std::getline(file, header) || !std::getline(file, values)) {
+        throw std::runtime_error("cannot read " + path.string());
+    }
+
+    std::vector<std::pair<int, int>> expected;
+    std::istringstream headers(header);
+    std::istringstream cells(values);
+    std::string name;
+    std::string cell;
+    std::getline(headers, name, '|');
+    std::getline(cells, cell, '|');
+    while (std::getline(headers, name, '|') && std::getline(cells, cell, '|')) {
+        std::size_t open { name.find('[') };
+        if (open == std::string::npos) { continue; }
+        expected.emplace_back(std::stoi(name.substr(open + 1)), std::stoi(cell));
+    }
+    return expected;
+}
+
+}
+
+/*
+Compiles a test program with --emit=hack and the provided flags, runs it on the Hack CPU, and compares the RAM
+locations listed in the program's <dirname>.cmp file. The sources are copied into a directory named after the program
+and the flags under hack-test in the working directory, so that the program is assembled there.
+
+Usage: HackTest <compiler> <dirname> [flags...]
+*/
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: HackTest <compiler> <dirname> [flags...]\n";
+        return 1;
+    }
+
+    fs::path source { fs::path(argv[2]).lexically_normal() };
+    if (!source.has_filename()) { source = source.parent_path(); }
+    std::string name { source.filename().string() };
+
+    std::string flags;
+    std::string build { name };
+    for (int i = 3; i < argc; ++i) {
+        flags += ' ';
+        flags += argv[i];
+        build += argv[i];
+    }
+
+    try {
+        fs::path work { fs::current_path() / "hack-test" / build };
+        fs::remove_all(work);
+        fs::create_directories(work);
+        for (const fs::directory_entry& file : fs::directory_iterator(source)) {
+            if (file.path().extension() == ".jack") {
+                fs::copy_file(file.path(), work / file.path().filename());
+            }
+        }
+
+        std::string command { '"' + std::string(argv[1]) + "\" \"" + work.string() + "\" --emit=hack" + flags };
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "compilation failed: " << command << '\n';
+            return 1;
+        }
+
+        Cpu cpu(readProgram(work / (build + ".hack")));
+        if (!cpu.run()) {
+            std::cerr << "program did not halt\n";
+            return 1;
+        }
+
+        int failures { 0 };
+        for (const auto& [address, value] : readExpected(source / (name + ".cmp"))) {
+            if (cpu.peek(address) != value) {
+                std::cerr << "RAM[" << address << "]: expected " << value << ", got " << cpu.peek(address) << '\n';
+                ++failures;
+            }
+        }
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+}
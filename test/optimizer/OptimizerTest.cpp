@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int STATIC_BASE { 16 };
+constexpr int TEMP_BASE { 5 };
+constexpr int HEAP_BASE { 2048 };
+constexpr long MAX_STEPS { 10000000 };
+
+// each build is compared against the build without flags
+const std::vector<std::vector<std::string>> BUILDS {
+    { "-O" },
+    { "--pool-strings" },
+    { "--prune" },
+    { "--inline" },
+    { "-O", "--inline", "--prune", "--pool-strings" }
+};
+
+enum class Op { PUSH, POP, ARITHMETIC, LABEL, GOTO, IF, CALL, RETURN };
+
+struct Instruction {
+    Op op;
+    std::string name;
+    int arg;
+};
+
+struct Function {
+    std::string className;
+    int nVars;
+    std::vector<Instruction> code;
+    std::unordered_map<std::string, std::size_t> labels;
+};
+
+/*
+A small VM interpreter for the test programs. It follows the memory layout of the VM emulator: temp at 5-12,
+statics from 16, one class after another in load order, and the heap from 2048. this and that address RAM, so
+arrays may alias objects and statics. Locals and arguments live in the interpreter's own frames. Of the OS, only
+Memory.alloc, Array.new, Math.multiply, Math.divide, String.new, String.appendChar and the Output print functions are
+provided; what the program prints is collected as its output.
+*/
+class Machine {
+public:
+    Machine(const fs::path& dirname) :
+        ram(32768, 0) {
+        std::vector<fs::path> files;
+        for (const fs::directory_entry& file : fs::directory_iterator(dirname)) {
+            if (file.path().extension() == ".vm") {
+                files.push_back(file.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        int next { STATIC_BASE };
+        for (const fs::path& file : files) {
+            std::string className { file.stem().string() };
+            staticBases[className] = next;
+            next += load(file, className);
+        }
+    }
+
+    std::string run(const std::string& entry) {
+        call(entry, {});
+        return output;
+    }
+
+private:
+    std::vector<std::int16_t> ram;
+    std::unordered_map<std::string, Function> functions;
+    std::unordered_map<std::string, int> staticBases;
+    std::string output;
+    int heap { HEAP_BASE };
+    long steps { 0 };
+
+    // returns the number of statics the class uses
+    int load(const fs::path& path, const std::string& className) {
+        std::ifstream file(path);
+        std::string line;
+        Function* function { nullptr };
+        int statics { 0 };
+
+        while (std::getline(file, line)) {
+            std::istringstream words(line);
+            std::string command;
+            std::string name;
+            int arg { 0 };
+            if (!(words >> command) || command.rfind("//", 0) == 0) { continue; }
+            words >> name >> arg;
+
+            if (command == "function") {
+                function = &functions[name];
+                function->className = className;
+                function->nVars = arg;
+                continue;
+            }
+            if (function == nullptr) { throw std::runtime_error("command outside a function in " + path.string()); }
+
+            std::vector<Instruction>& code { function->code };
+            if (command == "push" || command == "pop") {
+                code.push_back({ command == "push" ? Op::PUSH : Op::POP, name, arg });
+                if (name == "static") { statics = std::max(statics, arg + 1); }
+            } else if (command == "label") {
+                function->labels[name] = code.size();
+                code.push_back({ Op::LABEL, name, 0 });
+            } else if (command == "goto") {
+                code.push_back({ Op::GOTO, name, 0 });
+            } else if (command == "if-goto") {
+                code.push_back({ Op::IF, name, 0 });
+            } else if (command == "call") {
+                code.push_back({ Op::CALL, name, arg });
+            } else if (command == "return") {
+                code.push_back({ Op::RETURN, "", 0 });
+            } else {
+                code.push_back({ Op::ARITHMETIC, command, 0 });
+            }
+        }
+        return statics;
+    }
+
+    std::int16_t callBuiltin(const std::string& name, const std::vector<std::int16_t>& args) {
+        if (name == "Memory.alloc" || name == "Array.new") {
+            std::int16_t block { static_cast<std::int16_t>(heap) };
+            heap += args[0];
+            return block;
+        }
+        if (name == "Math.multiply") { return static_cast<std::int16_t>(args[0] * args[1]); }
+        if (name == "Math.divide") { return static_cast<std::int16_t>(args[0] / args[1]); }
+
+        // a string is its length followed by its characters
+        if (name == "String.new") { return callBuiltin("Memory.alloc", { static_cast<std::int16_t>(args[0] + 1) }); }
+        if (name == "String.appendChar") {
+            std::int16_t& length { ram.at(args[0]) };
+            ram.at(args[0] + 1 + length) = args[1];
+            ++length;
+            return args[0];
+        }
+
+        if (name == "Output.printInt") {
+            output += std::to_string(args[0]);
+            return 0;
+        }
+        if (name == "Output.printChar") {
+            output += static_cast<char>(args[0]);
+            return 0;
+        }
+        if (name == "Output.printString") {
+            for (int i = 0; i < ram.at(args[0]); ++i) {
+                output += static_cast<char>(ram.at(args[0] + 1 + i));
+            }
+            return 0;
+        }
+        throw std::runtime_error("undefined function " + name);
+    }
+
+    // this and that are saved and restored around every call, as the VM calling convention does
+    std::int16_t call(const std::string& name, std::vector<std::int16_t> args) {
+        auto it { functions.find(name) };
+        if (it == functions.end()) { return callBuiltin(name, args); }
+
+        std::int16_t savedThis { ram[3] };
+        std::int16_t savedThat { ram[4] };
+        std::int16_t result { execute(it->second, args) };
+        ram[3] = savedThis;
+        ram[4] = savedThat;
+        return result;
+    }
+
+    std::int16_t& location(const Instruction& instruction, std::vector<std::int16_t>& locals, std::vector<std::int16_t>& args, int staticBase) {
+        const std::string& segment { instruction.name };
+        if (segment == "local")    { return locals.at(instruction.arg); }
+        if (segment == "argument") { return args.at(instruction.arg); }
+        if (segment == "this")     { return ram.at(static_cast<std::uint16_t>(ram[3] + instruction.arg)); }
+        if (segment == "that")     { return ram.at(static_cast<std::uint16_t>(ram[4] + instruction.arg)); }
+        if (segment == "pointer")  { return ram.at(3 + instruction.arg); }
+        if (segment == "temp")     { return ram.at(TEMP_BASE + instruction.arg); }
+        if (segment == "static")   { return ram.at(staticBase + instruction.arg); }
+        throw std::runtime_error("bad segment " + segment);
+    }
+
+    std::int16_t execute(const Function& function, std::vector<std::int16_t>& args) {
+        std::vector<std::int16_t> locals(function.nVars, 0);
+        std::vector<std::int16_t> stack;
+        int staticBase { staticBases.at(function.className) };
+
+        auto pop { [&] {
+            if (stack.empty()) { throw std::runtime_error("stack underflow"); }
+            std::int16_t value { stack.back() };
+            stack.pop_back();
+            return value;
+        } };
+
+        for (std::size_t pc = 0; pc < function.code.size(); ++pc) {
+            if (++steps > MAX_STEPS) { throw std::runtime_error("step limit reached"); }
+
+            const Instruction& instruction { function.code[pc] };
+            switch (instruction.op) {
+                case Op::PUSH:
+                    if (instruction.name == "constant") {
+                        stack.push_back(static_cast<std::int16_t>(instruction.arg));
+                    } else {
+                        stack.push_back(location(instruction, locals, args, staticBase));
+                    }
+                    break;
+                case Op::POP: {
+                    std::int16_t value { pop() };
+                    location(instruction, locals, args, staticBase) = value;
+                    break;
+                }
+                case Op::ARITHMETIC: {
+                    const std::string& command { instruction.name };
+                    if (command == "neg" || command == "not") {
+                        std::int16_t x { pop() };
+                        stack.push_back(static_cast<std::int16_t>(command == "neg" ? -x : ~x));
+                        break;
+                    }
+                    std::int16_t y { pop() };
+                    std::int16_t x { pop() };
+                    if (command == "add")      { stack.push_back(static_cast<std::int16_t>(x + y)); }
+                    else if (command == "sub") { stack.push_back(static_cast<std::int16_t>(x - y)); }
+                    else if (command == "and") { stack.push_back(static_cast<std::int16_t>(x & y)); }
+                    else if (command == "or")  { stack.push_back(static_cast<std::int16_t>(x | y)); }
+                    else if (command == "eq")  { stack.push_back(x == y ? -1 : 0); }
+                    else if (command == "gt")  { stack.push_back(x > y ? -1 : 0); }
+                    else if (command == "lt")  { stack.push_back(x < y ? -1 : 0); }
+                    else { throw std::runtime_error("bad command " + command); }
+                    break;
+                }
+                case Op::LABEL:
+                    break;
+                case Op::GOTO:
+                    pc = function.labels.at(instruction.name);
+                    break;
+                case Op::IF:
+                    if (pop() != 0) { pc = function.labels.at(instruction.name); }
+                    break;
+                case Op::CALL: {
+                    if (stack.size() < static_cast<std::size_t>(instruction.arg)) { throw std::runtime_error("stack underflow"); }
+                    std::vector<std::int16_t> callArgs(stack.end() - instruction.arg, stack.end());
+                    stack.resize(stack.size() - instruction.arg);
+                    stack.push_back(call(instruction.name, std::move(callArgs)));
+                    break;
+                }
+                case Op::RETURN:
+                    return pop();
+            }
+        }
+        throw std::runtime_error("function ended without return");
+    }
+};
+
+// compiles a copy of the program's sources with the provided flags, then runs it from Main.main
+std::string runBuild(const std::string& compiler, const fs::path& source, const fs::path& work, const std::vector<std::string>& flags) {
+    fs::remove_all(work);
+    fs::create_directories(work);
+    for (const fs::directory_entry& file : fs::directory_iterator(source)) {
+        if (file.path().extension() == ".jack") {
+            fs::copy_file(file.path(), work / file.path().filename());
+        }
+    }
+
+    std::string command { '"' + compiler + "\" \"" + work.string() + '"' };
+    for (const std::string& flag : flags) {
+        command += ' ' + flag;
+    }
+    command += " > \"" + (work / "compile.log").string() + '"';
+    if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error("compilation failed: " + command);
+    }
+
+    return Machine(work).run("Main.main");
+}
+
+}
+
+/*
+Compiles a test program without flags and then with each set of flags in BUILDS, runs every build from Main.main,
+and fails unless they all print the same output. The sources are copied into directories named after the program and
+the flags under optimizer-test in the working directory, so that each build is compiled there.
+
+Usage: OptimizerTest <compiler> <dirname>
+*/
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: OptimizerTest <compiler> <dirname>\n";
+        return 1;
+    }
+
+    fs::path source { fs::path(argv[2]).lexically_normal() };
+    if (!source.has_filename()) { source = source.parent_path(); }
+    fs::path workRoot { fs::current_path() / "optimizer-test" };
+    std::string name { source.filename().string() };
+
+    try {
+        std::string expected { runBuild(argv[1], source, workRoot / name, {}) };
+        std::cout << "(no flags): " << expected << '\n';
+
+        int failures { 0 };
+        for (const std::vector<std::string>& flags : BUILDS) {
+            std::string label;
+            std::string build { name };
+            for (const std::string& flag : flags) {
+                label += (label.empty() ? "" : " ") + flag;
+                build += flag;
+            }
+
+            std::string output;
+            try {
+                output = runBuild(argv[1], source, workRoot / build, flags);
+            } catch (const std::exception& error) {
+                output = error.what();
+            }
+
+            std::cout << label << ": " << output << '\n';
+            if (output != expected) { ++failures; }
+        }
+        return failures == 0 ? 0 : 1;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+}